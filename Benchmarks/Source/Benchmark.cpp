@@ -0,0 +1,228 @@
+#include "Benchmark.h"
+#include "../../Source/FilterDesigner.h"
+
+namespace
+{
+    constexpr int minNumBlocks = 16;
+    constexpr int sourceLength = 1 << 16;
+
+    constexpr float designFrequency = 0.2f * (float)BenchmarkEngine::sampleRate;
+    constexpr float designTransitionWidth = 0.05f;
+    constexpr float designStopBandWeight = 1.f;
+
+    var toVar (const Array<int>& values)
+    {
+        Array<var> result;
+
+        for (auto value : values)
+            result.add (value);
+
+        return result;
+    }
+
+    /** Best of a few runs in milliseconds; slow designs are only run once. */
+    template <typename Function>
+    double measureMilliseconds (Function&& design)
+    {
+        auto best = std::numeric_limits<double>::max ();
+
+        for (int run = 0; run < 3; ++run)
+        {
+            const auto start = Time::getHighResolutionTicks ();
+            design ();
+            best = jmin (best, Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks () - start) * 1.0e3);
+
+            if (best > 1000.0)
+                break;
+        }
+
+        return best;
+    }
+}
+
+Benchmark::Benchmark (const Settings& s)
+    : settings (s)
+{
+    const auto megahertz = settings.cpuMegahertz > 0.0 ? settings.cpuMegahertz : (double)SystemStats::getCpuSpeedInMegahertz ();
+    cyclesPerSecond = megahertz * 1.0e6;
+}
+
+var Benchmark::run ()
+{
+    Array<var> results;
+
+    for (auto& name : settings.engines)
+    {
+        for (auto numTaps : settings.numTaps)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                for (auto numChannels : settings.numChannels)
+                {
+                    std::cerr << name << ", " << numTaps << " taps, block " << blockSize << ", " << numChannels << " ch" << std::endl;
+
+                    auto result = runEngine (name, numTaps, blockSize, numChannels);
+
+                    if (! result.isVoid ())
+                        results.add (result);
+                }
+            }
+        }
+    }
+
+    DynamicObject::Ptr report = new DynamicObject ();
+    report->setProperty ("version", 1);
+    report->setProperty ("date", Time::getCurrentTime ().toISO8601 (true));
+    report->setProperty ("system", getSystemInfo ());
+    report->setProperty ("settings", getSettings ());
+    report->setProperty ("results", results);
+
+    if (settings.includeDesigns)
+        report->setProperty ("designs", runDesigns ());
+
+    return report.get ();
+}
+
+var Benchmark::getSystemInfo () const
+{
+    DynamicObject::Ptr info = new DynamicObject ();
+    info->setProperty ("cpu", SystemStats::getCpuModel ());
+    info->setProperty ("cpuMegahertz", cyclesPerSecond * 1.0e-6);
+    info->setProperty ("numCpus", SystemStats::getNumCpus ());
+    info->setProperty ("instructionSet", InterleavedConvolution::getName (InterleavedConvolution::getBestInstructionSet ()));
+    info->setProperty ("os", SystemStats::getOperatingSystemName ());
+    info->setProperty ("juce", SystemStats::getJUCEVersion ());
+    return info.get ();
+}
+
+var Benchmark::getSettings () const
+{
+    DynamicObject::Ptr result = new DynamicObject ();
+    result->setProperty ("sampleRate", BenchmarkEngine::sampleRate);
+    result->setProperty ("engines", settings.engines);
+    result->setProperty ("numTaps", toVar (settings.numTaps));
+    result->setProperty ("blockSizes", toVar (settings.blockSizes));
+    result->setProperty ("numChannels", toVar (settings.numChannels));
+    result->setProperty ("secondsPerRun", settings.secondsPerRun);
+    return result.get ();
+}
+
+var Benchmark::runEngine (const String& name, int numTaps, int blockSize, int numChannels) const
+{
+    auto engine = BenchmarkEngine::create (name);
+
+    if (engine == nullptr || ! engine->supports (numTaps, numChannels))
+        return {};
+
+    const dsp::ProcessSpec spec { BenchmarkEngine::sampleRate, (uint32)blockSize, (uint32)numChannels };
+    engine->prepare (spec, BenchmarkEngine::createTaps (numTaps));
+
+    AudioBuffer<float> source (numChannels, sourceLength);
+    AudioBuffer<float> buffer (numChannels, blockSize);
+    Random random (0x5eed);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < sourceLength; ++i)
+            source.setSample (ch, i, random.nextFloat () * 2.f - 1.f);
+
+    ScopedNoDenormals noDenormals;
+    dsp::AudioBlock<float> block (buffer);
+    int sourcePosition = 0;
+
+    // fresh input for every block, so that repeated filtering cannot decay into denormals
+    auto processBlock = [&]
+    {
+        if (sourcePosition + blockSize > sourceLength)
+            sourcePosition = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffer.copyFrom (ch, 0, source, ch, sourcePosition, blockSize);
+
+        sourcePosition += blockSize;
+
+        const auto start = Time::getHighResolutionTicks ();
+        engine->process (dsp::ProcessContextReplacing<float> (block));
+        return Time::getHighResolutionTicks () - start;
+    };
+
+    const auto numWarmUpBlocks = 2 + (numTaps + engine->getLatencyInSamples ()) / blockSize;
+
+    for (int i = 0; i < numWarmUpBlocks; ++i)
+        processBlock ();
+
+    int64 totalTicks = 0;
+    int64 worstTicks = 0;
+    int numBlocks = 0;
+
+    while (numBlocks < minNumBlocks || Time::highResolutionTicksToSeconds (totalTicks) < settings.secondsPerRun)
+    {
+        const auto ticks = processBlock ();
+        totalTicks += ticks;
+        worstTicks = jmax (worstTicks, ticks);
+        ++numBlocks;
+    }
+
+    const auto seconds = Time::highResolutionTicksToSeconds (totalTicks);
+    const auto numSamples = (double)numBlocks * blockSize * numChannels;
+
+    DynamicObject::Ptr result = new DynamicObject ();
+    result->setProperty ("engine", name);
+    result->setProperty ("numTaps", numTaps);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("numChannels", numChannels);
+    result->setProperty ("latency", engine->getLatencyInSamples ());
+    result->setProperty ("numBlocks", numBlocks);
+    result->setProperty ("nanosecondsPerSample", seconds * 1.0e9 / numSamples);
+    result->setProperty ("macsPerCycle", numTaps * numSamples / (seconds * cyclesPerSecond));
+    result->setProperty ("meanBlockMicroseconds", seconds * 1.0e6 / numBlocks);
+    result->setProperty ("worstBlockMicroseconds", Time::highResolutionTicksToSeconds (worstTicks) * 1.0e6);
+    result->setProperty ("budgetMicroseconds", blockSize * 1.0e6 / BenchmarkEngine::sampleRate);
+    return result.get ();
+}
+
+var Benchmark::runDesigns () const
+{
+    using FilterDesign = dsp::FilterDesign<float>;
+    const auto sampleRate = BenchmarkEngine::sampleRate;
+
+    Array<var> results;
+
+    auto add = [&] (const String& designer, int order, double milliseconds)
+    {
+        DynamicObject::Ptr result = new DynamicObject ();
+        result->setProperty ("designer", designer);
+        result->setProperty ("order", order);
+        result->setProperty ("milliseconds", milliseconds);
+        results.add (result.get ());
+    };
+
+    for (auto order : settings.designOrders)
+    {
+        std::cerr << "designs, order " << order << std::endl;
+
+        add ("juceWindow", order, measureMilliseconds ([&] {
+            FilterDesign::designFIRLowpassWindowMethod (designFrequency, sampleRate, (size_t)order, dsp::WindowingFunction<float>::hamming);
+        }));
+
+        add ("digitalFilterWindow", order, measureMilliseconds ([&] {
+            DigitalFilter::FIRFilter (DigitalFilter::LowPass, DigitalFilter::Hamming, order + 1, (float)sampleRate, designFrequency);
+        }));
+
+        if (order <= settings.maxJuceDesignOrder)
+        {
+            add ("juceLeastSquares", order, measureMilliseconds ([&] {
+                FilterDesign::designFIRLowpassLeastSquaresMethod (designFrequency, sampleRate, (size_t)order, designTransitionWidth, designStopBandWeight);
+            }));
+        }
+
+        add ("levinsonLeastSquares", order, measureMilliseconds ([&] {
+            FilterDesigner::designFIRLowpassLeastSquaresMethod (designFrequency, sampleRate, (size_t)order, designTransitionWidth, designStopBandWeight);
+        }));
+
+        add ("equiripple", order, measureMilliseconds ([&] {
+            FilterDesigner::designFIRLowpassEquirippleMethod (designFrequency, sampleRate, (size_t)order, designTransitionWidth, designStopBandWeight);
+        }));
+    }
+
+    return results;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BenchmarkEngines.h"
+
+/** Times every engine over a matrix of tap counts, block sizes and channel counts.
+
+    Each configuration processes noise block by block, after enough warm-up blocks to fill
+    the engine's history, until at least secondsPerRun have been spent inside process().
+    Only the process() calls are timed. For every run the report holds
+
+        nanosecondsPerSample    mean time per sample and channel
+        macsPerCycle            numTaps multiply-adds per sample and channel divided by the
+                                CPU cycles spent, i.e. what a direct-form filter would need;
+                                the FFT engines reach more than the hardware can do directly
+        meanBlockMicroseconds   mean and worst time for one block, next to the block's duration
+        worstBlockMicroseconds  at 48 kHz, which is the real-time budget
+        budgetMicroseconds
+
+    Cycles are derived from the CPU clock reported by the system, or from cpuMegahertz when
+    set, so macsPerCycle is only as accurate as that clock while turbo modes are active.
+
+    With includeDesigns the report also times the JUCE designers against FilterDesigner for
+    the orders in designOrders. JUCE's least squares method is O(N^3), so it is only run up
+    to maxJuceDesignOrder.
+*/
+class Benchmark
+{
+public:
+    struct Settings
+    {
+        StringArray engines = BenchmarkEngine::getNames ();
+        Array<int> numTaps { 16, 64, 256, 1024, 4096 };
+        Array<int> blockSizes { 32, 128, 512 };
+        Array<int> numChannels { 1, 2, 8 };
+        double secondsPerRun = 0.1;
+        double cpuMegahertz = 0.0;
+
+        bool includeDesigns = false;
+        Array<int> designOrders { 64, 256, 1024, 4096 };
+        int maxJuceDesignOrder = 1024;
+    };
+
+    explicit Benchmark (const Settings& settings);
+
+    /** Runs everything and returns the report, ready for JSON::toString(). Progress goes to stderr. */
+    var run ();
+
+private:
+    var getSystemInfo () const;
+    var getSettings () const;
+    var runEngine (const String& name, int numTaps, int blockSize, int numChannels) const;
+    var runDesigns () const;
+
+    Settings settings;
+    double cyclesPerSecond = 0.0;
+};
@@ -0,0 +1,177 @@
+#include "BenchmarkEngines.h"
+
+namespace
+{
+    using Coefficients = dsp::FIR::Coefficients<float>;
+
+    /** dsp::FIR::Filter, one per channel; what FirFilter runs in its Direct mode. */
+    struct JuceEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            filter.state = new Coefficients (taps.data (), taps.size ());
+            filter.prepare (spec);
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { filter.process (context); }
+
+        dsp::ProcessorDuplicator<dsp::FIR::Filter<float>, Coefficients> filter;
+    };
+
+    /** DirectConvolution, either plain (SIMD Direct) or with the folded linear-phase kernel,
+        summing in float, double or with Kahan compensation.
+    */
+    struct DirectEngine : public BenchmarkEngine
+    {
+        using Accumulation = DirectConvolution::Accumulation;
+
+        DirectEngine (bool shouldFold, Accumulation a = Accumulation::single) : fold (shouldFold), accumulation (a) {}
+
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            Coefficients::Ptr coefficients = new Coefficients (taps.data (), taps.size ());
+            const auto symmetry = fold ? DirectConvolution::findSymmetry (taps.data (), (int)taps.size ())
+                                       : DirectConvolution::Symmetry::none;
+
+            convolution.prepare (spec, (int)taps.size ());
+            convolution.setCoefficients (coefficients, symmetry);
+            convolution.setAccumulation (accumulation);
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { convolution.process (context); }
+
+        bool fold;
+        Accumulation accumulation;
+        DirectConvolution convolution;
+    };
+
+    struct InterleavedEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            convolution.prepare (spec, (int)taps.size ());
+            convolution.setCoefficients (convolution.createExpandedCoefficients (Coefficients (taps.data (), taps.size ())));
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { convolution.process (context); }
+
+        bool supports (int, int numChannels) const override { return numChannels <= InterleavedConvolution::maxGroupSize; }
+
+        InterleavedConvolution convolution;
+    };
+
+    struct PartitionedEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            const auto partitionSize = UniformPartitionedConvolution::getPartitionSizeForBlockSize ((int)spec.maximumBlockSize);
+
+            convolution.prepare (spec, partitionSize, (int)taps.size ());
+            convolution.setImpulseResponse (new PartitionedImpulseResponse (taps.data (), (int)taps.size (), partitionSize));
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { convolution.process (context); }
+
+        int getLatencyInSamples () const override { return convolution.getLatencyInSamples (); }
+
+        UniformPartitionedConvolution convolution;
+    };
+
+    struct NonUniformEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            convolution.prepare (spec, (int)taps.size ());
+            convolution.startWorker ();
+            convolution.setImpulseResponse (convolution.createImpulseResponse (taps.data (), (int)taps.size ()));
+
+            // the harness calls as fast as it can rather than once per block duration, so there is no deadline to drop partitions for
+            convolution.setNonRealtime (true);
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { convolution.process (context); }
+
+        NonUniformPartitionedConvolution convolution;
+    };
+
+    struct DigitalFilterEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            filter = std::make_unique<DigitalFilter::FIRFilter> (DigitalFilter::LowPass, DigitalFilter::Hamming, (int)taps.size (),
+                                                                 (float)spec.sampleRate, cutoffFrequency);
+            filter->prepare (spec);
+            designedTaps = filter->GetImpulseResponse ();
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { filter->process (context); }
+
+        const std::vector<float>* getDesignedTaps () const override { return &designedTaps; }
+
+        std::unique_ptr<DigitalFilter::FIRFilter> filter;
+        std::vector<float> designedTaps;
+    };
+
+    struct ChatGPTEngine : public BenchmarkEngine
+    {
+        void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) override
+        {
+            filter.prepare (spec);
+            filter.setLowpass (cutoffFrequency, (int)taps.size ());
+        }
+
+        void process (const dsp::ProcessContextReplacing<float>& context) override { filter.process (context); }
+
+        const std::vector<float>* getDesignedTaps () const override { return &filter.getCoefficients (); }
+
+        // the ring buffer holds 8192 samples per channel
+        bool supports (int numTaps, int) const override { return numTaps <= 8192; }
+
+        FIRLinearPhaseFilter filter;
+    };
+}
+
+StringArray BenchmarkEngine::getNames ()
+{
+    return { "juce", "simdDirect", "simdDirectDouble", "simdDirectKahan", "folded", "foldedDouble", "foldedKahan", "interleaved", "partitioned", "nonUniform", "digitalFilter", "chatGPT" };
+}
+
+std::unique_ptr<BenchmarkEngine> BenchmarkEngine::create (const String& name)
+{
+    if (name == "juce")           return std::make_unique<JuceEngine> ();
+    if (name == "simdDirect")     return std::make_unique<DirectEngine> (false);
+    if (name == "folded")         return std::make_unique<DirectEngine> (true);
+
+    if (name == "simdDirectDouble")  return std::make_unique<DirectEngine> (false, DirectConvolution::Accumulation::doublePrecision);
+    if (name == "simdDirectKahan")   return std::make_unique<DirectEngine> (false, DirectConvolution::Accumulation::compensated);
+    if (name == "foldedDouble")      return std::make_unique<DirectEngine> (true, DirectConvolution::Accumulation::doublePrecision);
+    if (name == "foldedKahan")       return std::make_unique<DirectEngine> (true, DirectConvolution::Accumulation::compensated);
+
+    if (name == "interleaved")    return std::make_unique<InterleavedEngine> ();
+    if (name == "partitioned")    return std::make_unique<PartitionedEngine> ();
+    if (name == "nonUniform")     return std::make_unique<NonUniformEngine> ();
+    if (name == "digitalFilter")  return std::make_unique<DigitalFilterEngine> ();
+    if (name == "chatGPT")        return std::make_unique<ChatGPTEngine> ();
+
+    return nullptr;
+}
+
+std::vector<float> BenchmarkEngine::createTaps (int numTaps, double cutoff)
+{
+    std::vector<float> taps ((size_t)numTaps);
+    const auto centre = (numTaps - 1) / 2.0;
+
+    for (int k = 0; k < numTaps; ++k)
+    {
+        const auto d = k - centre;
+        const auto sinc = d == 0.0 ? 2.0 * cutoff : std::sin (MathConstants<double>::twoPi * cutoff * d) / (MathConstants<double>::pi * d);
+        const auto window = numTaps > 1 ? 0.54 - 0.46 * std::cos (MathConstants<double>::twoPi * k / (numTaps - 1)) : 1.0;
+        taps[(size_t)k] = (float)(sinc * window);
+    }
+
+    // mirror, so that rounding cannot break the symmetry the folded kernels look for
+    for (int k = 0; k < numTaps / 2; ++k)
+        taps[(size_t)(numTaps - 1 - k)] = taps[(size_t)k];
+
+    return taps;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/DirectConvolution.h"
+#include "../../Source/InterleavedConvolution.h"
+#include "../../Source/PartitionedConvolution.h"
+#include "../../Source/NonUniformConvolution.h"
+#include "../../Source/DigitalFilter.h"
+#include "../../Source/ChatGPTFilter.h"
+
+/** One FIR implementation behind a common interface, so the harness can drive them all alike.
+
+    Every engine is given the same taps: an exactly symmetric Hamming-windowed sinc lowpass
+    (see createTaps), so that the folded engine really folds. DigitalFilter::FIRFilter and
+    FIRLinearPhaseFilter cannot be handed coefficients, so they design a lowpass of the same
+    length themselves; the cost is the same either way.
+*/
+struct BenchmarkEngine
+{
+    virtual ~BenchmarkEngine () = default;
+
+    /** Allocates everything and installs the taps. Not timed. */
+    virtual void prepare (const dsp::ProcessSpec& spec, const std::vector<float>& taps) = 0;
+    virtual void process (const dsp::ProcessContextReplacing<float>& context) = 0;
+
+    virtual int getLatencyInSamples () const { return 0; }
+
+    /** The taps actually convolved, for the engines that design their own; nullptr otherwise. */
+    virtual const std::vector<float>* getDesignedTaps () const { return nullptr; }
+
+    /** False for configurations the engine cannot run, which are then left out. */
+    virtual bool supports (int /*numTaps*/, int /*numChannels*/) const { return true; }
+
+    static StringArray getNames ();
+    static std::unique_ptr<BenchmarkEngine> create (const String& name);
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr float cutoffFrequency = 0.2f * (float)sampleRate;
+
+    /** Hamming-windowed sinc lowpass at cutoff, relative to the sample rate. */
+    static std::vector<float> createTaps (int numTaps, double cutoff = cutoffFrequency / sampleRate);
+};
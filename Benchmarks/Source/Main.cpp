@@ -0,0 +1,149 @@
+#include <JuceHeader.h>
+#include "Benchmark.h"
+#include "Verification.h"
+
+namespace
+{
+    Array<int> parseIntegers (const String& list)
+    {
+        Array<int> result;
+
+        for (auto& token : StringArray::fromTokens (list, ",", {}))
+            if (token.trim ().getIntValue () > 0)
+                result.add (token.trim ().getIntValue ());
+
+        return result;
+    }
+
+    /** Runs the verification while the main thread handles FirFilter's messages. */
+    class VerificationThread : public Thread
+    {
+    public:
+        VerificationThread (const Verification::Settings& s) : Thread ("Verification"), verification (s) {}
+
+        void run () override
+        {
+            report = verification.run ();
+            MessageManager::getInstance ()->stopDispatchLoop ();
+        }
+
+        Verification verification;
+        var report;
+    };
+
+    bool writeReport (const ArgumentList& args, const String& json)
+    {
+        if (! args.containsOption ("--output"))
+        {
+            std::cout << json << std::endl;
+            return true;
+        }
+
+        const auto file = File::getCurrentWorkingDirectory ().getChildFile (args.getValueForOption ("--output"));
+
+        if (! file.replaceWithText (json + "\n"))
+        {
+            std::cerr << "Cannot write " << file.getFullPathName () << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void printUsage ()
+    {
+        std::cout << "FIR Benchmarks - times every FIR engine in Source/ and prints a JSON report\n\n"
+                     "  --engines=a,b,...   engines to run, any of " << BenchmarkEngine::getNames ().joinIntoString (",") << "\n"
+                     "  --taps=n,...        tap counts (default 16,64,256,1024,4096)\n"
+                     "  --blocks=n,...      block sizes (default 32,128,512)\n"
+                     "  --channels=n,...    channel counts (default 1,2,8)\n"
+                     "  --seconds=s         minimum time spent per configuration (default 0.1)\n"
+                     "  --cpu-mhz=f         clock used for MACs per cycle instead of the reported one\n"
+                     "  --designs           also time the coefficient designers\n"
+                     "  --design-orders=n,. orders for the design timings (default 64,256,1024,4096)\n"
+                     "  --output=file       write the report to a file instead of stdout\n\n"
+                     "  --verify            check the engines against a double precision reference instead\n"
+                     "                      of timing them; takes --engines, --taps and --blocks, and exits\n"
+                     "                      with 1 if any error is over its budget\n"
+                     "  --engines-only      with --verify, leave out the FirFilter scenarios\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage ();
+        return 0;
+    }
+
+    StringArray engines = BenchmarkEngine::getNames ();
+
+    if (args.containsOption ("--engines"))
+    {
+        engines = StringArray::fromTokens (args.getValueForOption ("--engines"), ",", {});
+        engines.trim ();
+
+        for (auto& name : engines)
+        {
+            if (! BenchmarkEngine::getNames ().contains (name))
+            {
+                std::cerr << "Unknown engine: " << name << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (args.containsOption ("--verify"))
+    {
+        Verification::Settings settings;
+        settings.engines = engines;
+        settings.includeFirFilter = ! args.containsOption ("--engines-only");
+
+        if (args.containsOption ("--taps"))
+            settings.numTaps = parseIntegers (args.getValueForOption ("--taps"));
+
+        if (args.containsOption ("--blocks"))
+            settings.blockSizes = parseIntegers (args.getValueForOption ("--blocks"));
+
+        // FirFilter designs on the message thread, so this one has to run the message loop
+        ScopedJuceInitialiser_GUI juceInitialiser;
+        VerificationThread thread (settings);
+
+        thread.startThread ();
+        MessageManager::getInstance ()->runDispatchLoop ();
+        thread.stopThread (-1);
+
+        if (! writeReport (args, JSON::toString (thread.report)))
+            return 1;
+
+        return thread.verification.hasPassed () ? 0 : 1;
+    }
+
+    Benchmark::Settings settings;
+    settings.engines = engines;
+
+    if (args.containsOption ("--taps"))
+        settings.numTaps = parseIntegers (args.getValueForOption ("--taps"));
+
+    if (args.containsOption ("--blocks"))
+        settings.blockSizes = parseIntegers (args.getValueForOption ("--blocks"));
+
+    if (args.containsOption ("--channels"))
+        settings.numChannels = parseIntegers (args.getValueForOption ("--channels"));
+
+    if (args.containsOption ("--seconds"))
+        settings.secondsPerRun = args.getValueForOption ("--seconds").getDoubleValue ();
+
+    if (args.containsOption ("--cpu-mhz"))
+        settings.cpuMegahertz = args.getValueForOption ("--cpu-mhz").getDoubleValue ();
+
+    if (args.containsOption ("--design-orders"))
+        settings.designOrders = parseIntegers (args.getValueForOption ("--design-orders"));
+
+    settings.includeDesigns = args.containsOption ("--designs");
+
+    return writeReport (args, JSON::toString (Benchmark (settings).run ())) ? 0 : 1;
+}
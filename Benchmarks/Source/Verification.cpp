@@ -0,0 +1,547 @@
+#include "Verification.h"
+#include "../../Source/Filter.h"
+
+namespace
+{
+    constexpr int numChannels = 3;
+    constexpr double sampleRate = BenchmarkEngine::sampleRate;
+
+    constexpr double timeDomainBudget = 1.0e-5;
+    constexpr double fftBudget = 1.0e-4;
+    constexpr double latencyBudget = 1.0;     // in samples; the report is rounded, the delay need not be whole
+
+    /** Impulses, a sweep and noise, one per channel. */
+    AudioBuffer<float> createSignals (int length)
+    {
+        AudioBuffer<float> signals (numChannels, length);
+        signals.clear ();
+
+        for (auto position : { 0, 37, length / 2 + 11 })
+            if (position < length)
+                signals.setSample (0, position, 1.f);
+
+        // exponential sweep from 20 Hz to 20 kHz over the whole length
+        const auto rate = std::log (1000.0) / length;
+        const auto scale = MathConstants<double>::twoPi * 20.0 / sampleRate / rate;
+
+        for (int i = 0; i < length; ++i)
+            signals.setSample (1, i, (float)(0.9 * std::sin (scale * (std::exp (rate * i) - 1.0))));
+
+        Random random (0x5eed);
+
+        for (int i = 0; i < length; ++i)
+            signals.setSample (2, i, random.nextFloat () * 2.f - 1.f);
+
+        return signals;
+    }
+
+    /** The taps for one of the kernels, or nothing if the kernel cannot have numTaps taps. */
+    std::vector<float> createKernel (const String& kernel, int numTaps)
+    {
+        if (kernel == "lowpass")
+            return BenchmarkEngine::createTaps (numTaps);
+
+        if (kernel == "halfBand")
+        {
+            if (numTaps < 3 || numTaps % 2 == 0)
+                return {};
+
+            auto taps = BenchmarkEngine::createTaps (numTaps, 0.25);
+            const auto centre = numTaps / 2;
+
+            for (int k = 0; k < numTaps; ++k)
+                if (k != centre && (k - centre) % 2 == 0)
+                    taps[(size_t)k] = 0.f;
+
+            return taps;
+        }
+
+        if (kernel == "antisymmetric")
+        {
+            if (numTaps < 2)
+                return {};
+
+            auto taps = BenchmarkEngine::createTaps (numTaps);
+
+            for (int k = 0; k < numTaps; ++k)
+                taps[(size_t)k] = 2 * k + 1 < numTaps ? taps[(size_t)k] : (2 * k + 1 == numTaps ? 0.f : -taps[(size_t)k]);
+
+            return taps;
+        }
+
+        // decaying noise, without any symmetry
+        std::vector<float> taps ((size_t)numTaps);
+        Random random (numTaps);
+
+        for (int k = 0; k < numTaps; ++k)
+            taps[(size_t)k] = (random.nextFloat () * 2.f - 1.f) * std::exp (-4.f * (float)k / (float)numTaps);
+
+        return taps;
+    }
+
+    StringArray getKernelNames ()
+    {
+        return { "lowpass", "halfBand", "antisymmetric", "asymmetric" };
+    }
+
+    /** Largest difference between output and the reference over [from, to), normalised to the
+        largest output the taps can produce. The input before inputStart counts as silence.
+    */
+    template <typename Result>
+    void compare (Result& result, const AudioBuffer<float>& output, const AudioBuffer<float>& input, int inputStart,
+                  const std::vector<float>& taps, int latency, int from, int to)
+    {
+        double tapsSum = 0.0;
+
+        for (auto tap : taps)
+            tapsSum += std::abs ((double)tap);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* x = input.getReadPointer (ch);
+            const auto* y = output.getReadPointer (ch);
+            const auto peak = (double)input.getMagnitude (ch, 0, input.getNumSamples ());
+            const auto scale = tapsSum * peak > 0.0 ? 1.0 / (tapsSum * peak) : 1.0;
+
+            for (int n = from; n < to; ++n)
+            {
+                double reference = 0.0;
+                const auto newest = n - latency;
+
+                for (int k = 0; k < (int)taps.size () && newest - k >= inputStart; ++k)
+                    if (newest - k < input.getNumSamples ())
+                        reference += (double)taps[(size_t)k] * x[newest - k];
+
+                const auto error = std::abs (reference - (double)y[n]) * scale;
+
+                if (error > result.maxError)
+                {
+                    result.maxError = error;
+                    result.worstChannel = ch;
+                    result.worstSample = n;
+                }
+            }
+        }
+    }
+
+    /** Calls process for [start, end) of buffer, either in blocks of blockSize or in a mix of sizes up to it. */
+    template <typename Process>
+    void processInBlocks (AudioBuffer<float>& buffer, int start, int end, int blockSize, bool varyBlockSize, Process&& process)
+    {
+        const int sizes[] { blockSize, 1, blockSize / 2 + 1, 3, blockSize - 1, 7 };
+        dsp::AudioBlock<float> block (buffer);
+        int index = 0;
+
+        for (int position = start; position < end;)
+        {
+            const auto size = varyBlockSize ? jlimit (1, blockSize, sizes[index++ % (int)std::size (sizes)]) : blockSize;
+            const auto numSamples = jmin (size, end - position);
+
+            auto subBlock = block.getSubBlock ((size_t)position, (size_t)numSamples);
+            process (dsp::ProcessContextReplacing<float> (subBlock));
+            position += numSamples;
+        }
+    }
+
+    //==============================================================================
+    /** The smallest processor FirFilter can be attached to; the harness calls the filter directly. */
+    struct FilterHost : public AudioProcessor
+    {
+        FilterHost () : AudioProcessor (BusesProperties ()) {}
+
+        const String getName () const override { return "FilterHost"; }
+        void prepareToPlay (double, int) override {}
+        void releaseResources () override {}
+        void processBlock (AudioBuffer<float>&, MidiBuffer&) override {}
+        double getTailLengthSeconds () const override { return 0.0; }
+        bool acceptsMidi () const override { return false; }
+        bool producesMidi () const override { return false; }
+        AudioProcessorEditor* createEditor () override { return nullptr; }
+        bool hasEditor () const override { return false; }
+        int getNumPrograms () override { return 1; }
+        int getCurrentProgram () override { return 0; }
+        void setCurrentProgram (int) override {}
+        const String getProgramName (int) override { return {}; }
+        void changeProgramName (int, const String&) override {}
+        void getStateInformation (MemoryBlock&) override {}
+        void setStateInformation (const void*, int) override {}
+
+        /** Sets a parameter to a denormalised value, or a choice parameter to the named choice. */
+        void setParameter (const String& id, var value)
+        {
+            for (auto* parameter : getParameters ())
+            {
+                if (auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter); ranged != nullptr && ranged->getName (64) == id)
+                {
+                    if (auto* choice = dynamic_cast<AudioParameterChoice*> (ranged); choice != nullptr && value.isString ())
+                        value = choice->choices.indexOf (value.toString ());
+
+                    ranged->setValueNotifyingHost (ranged->convertTo0to1 ((float)value));
+                    return;
+                }
+            }
+
+            jassertfalse; // FirFilter has no such parameter
+        }
+
+        FirFilter filter { *this };
+    };
+
+    /** Returns once the message thread has handled everything posted before the call,
+        i.e. once FirFilter has queued the design for the last parameter change.
+    */
+    void waitForMessageThread ()
+    {
+        WaitableEvent done;
+        MessageManager::callAsync ([&done] { done.signal (); });
+        done.wait (10000);
+    }
+
+    /** FirFilter reports the latency on the message thread once a set is published, so a change means the set is ready. */
+    bool waitForLatencyChange (const AudioProcessor& processor, int oldLatency)
+    {
+        const auto timeout = Time::getMillisecondCounter () + 10000;
+
+        while (processor.getLatencySamples () == oldLatency)
+        {
+            if (Time::getMillisecondCounter () > timeout)
+                return false;
+
+            Thread::sleep (1);
+        }
+
+        return true;
+    }
+
+    std::vector<float> designFirFilterTaps (int order)
+    {
+        auto coefficients = dsp::FilterDesign<float>::designFIRLowpassWindowMethod (0.2f * (float)sampleRate, sampleRate, (size_t)order,
+                                                                                   dsp::WindowingFunction<float>::hamming);
+        return { coefficients->getRawCoefficients (), coefficients->getRawCoefficients () + coefficients->getFilterSize () };
+    }
+}
+
+Verification::Verification (const Settings& s)
+    : settings (s)
+{
+}
+
+double Verification::getErrorBudget (const String& name)
+{
+    return name == "partitioned" || name == "nonUniform" || name == "PartitionedFFT" || name == "NonUniformFFT" || name == "Auto"
+               ? fftBudget
+               : timeDomainBudget;
+}
+
+var Verification::run ()
+{
+    Array<var> results;
+    passed = true;
+
+    for (auto& name : settings.engines)
+    {
+        for (auto numTaps : settings.numTaps)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                for (auto varyBlockSize : { false, true })
+                {
+                    if (varyBlockSize && blockSize == 1)
+                        continue;
+
+                    for (auto& kernel : getKernelNames ())
+                    {
+                        auto result = runEngine (name, kernel, numTaps, blockSize, varyBlockSize);
+
+                        if (! result.isVoid ())
+                            results.add (result);
+                    }
+                }
+            }
+        }
+    }
+
+    if (settings.includeFirFilter)
+    {
+        runFirFilter (results);
+        runLatency (results);
+    }
+
+    DynamicObject::Ptr report = new DynamicObject ();
+    report->setProperty ("version", 1);
+    report->setProperty ("date", Time::getCurrentTime ().toISO8601 (true));
+    report->setProperty ("passed", passed);
+    report->setProperty ("results", results);
+    return report.get ();
+}
+
+var Verification::makeResult (DynamicObject::Ptr result, const Result& error, double budget, const String& description)
+{
+    const auto ok = error.maxError <= budget;
+    passed = passed && ok;
+
+    result->setProperty ("maxError", error.maxError);
+    result->setProperty ("budget", budget);
+    result->setProperty ("passed", ok);
+
+    if (! ok)
+        std::cerr << "FAIL " << description << ": error " << error.maxError << " at channel " << error.worstChannel
+                  << ", sample " << error.worstSample << " (budget " << budget << ")" << std::endl;
+
+    return result.get ();
+}
+
+var Verification::runEngine (const String& name, const String& kernel, int numTaps, int blockSize, bool varyBlockSize)
+{
+    auto engine = BenchmarkEngine::create (name);
+
+    if (engine == nullptr || ! engine->supports (numTaps, numChannels))
+        return {};
+
+    auto taps = createKernel (kernel, numTaps);
+
+    if (taps.empty ())
+        return {};
+
+    engine->prepare ({ sampleRate, (uint32)blockSize, (uint32)numChannels }, taps);
+
+    // the engines that design their own taps only run once, with what they designed
+    if (auto* designed = engine->getDesignedTaps ())
+    {
+        if (kernel != getKernelNames ()[0])
+            return {};
+
+        taps = *designed;
+    }
+
+    const auto latency = engine->getLatencyInSamples ();
+    const auto length = numTaps + latency + 8192;
+    const auto input = createSignals (length);
+
+    AudioBuffer<float> output (input);
+    processInBlocks (output, 0, length, blockSize, varyBlockSize, [&] (const dsp::ProcessContextReplacing<float>& context) { engine->process (context); });
+
+    Result error;
+    compare (error, output, input, 0, taps, latency, 0, length);
+
+    DynamicObject::Ptr result = new DynamicObject ();
+    result->setProperty ("engine", name);
+    result->setProperty ("kernel", kernel);
+    result->setProperty ("numTaps", numTaps);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("blocks", varyBlockSize ? "mixed" : "fixed");
+    result->setProperty ("latency", latency);
+
+    const auto description = name + ", " + kernel + ", " + String (numTaps) + " taps, block " + String (blockSize) + (varyBlockSize ? " mixed" : "");
+    return makeResult (result, error, getErrorBudget (name), description);
+}
+
+void Verification::runFirFilter (Array<var>& results)
+{
+    const StringArray modes { "Direct", "SIMDDirect", "PartitionedFFT", "NonUniformFFT", "InterleavedSIMD", "Morph", "Auto" };
+    const StringArray scenarios { "blocks", "offline", "swap", "resize", "double" };
+
+    constexpr int crossfadeMilliseconds = 10;
+
+    for (auto& mode : modes)
+    {
+        for (auto& scenario : scenarios)
+        {
+            std::cerr << "FirFilter, " << mode << ", " << scenario << std::endl;
+
+            const auto firstOrder = scenario == "swap" ? 254 : 511;
+            const auto secondOrder = 1023;
+            const auto maxBlockSize = scenario == "resize" ? 512 : 256;
+
+            FilterHost host;
+            host.setParameter ("Function", "LowpassWindowMethod");
+            host.setParameter ("Order", firstOrder);
+            host.setParameter ("Frequency", 0.2 * sampleRate);
+            host.setParameter ("WindowType", "hamming");
+            host.setParameter ("Resampling", "Off");
+            host.setParameter ("Phase", "Linear");
+            host.setParameter ("CrossfadeTime", mode == "Morph" ? crossfadeMilliseconds : 0);
+            host.setParameter ("Mode", mode);
+            host.setParameter ("Accumulation", scenario == "double" ? "Double" : "Single");
+            host.setNonRealtime (scenario == "offline");
+
+            // the designs queued by the changes above go stale once prepare() has designed synchronously
+            waitForMessageThread ();
+            host.filter.prepare ({ sampleRate, (uint32)maxBlockSize, (uint32)numChannels });
+
+            const auto firstTaps = designFirFilterTaps (firstOrder);
+            const auto firstLatency = host.getLatencySamples () - firstOrder / 2;
+
+            const auto length = 16384;
+            const auto half = length / 2;
+            const auto input = createSignals (length);
+            AudioBuffer<float> output (input);
+
+            AudioBuffer<double> hostBuffer (numChannels, maxBlockSize);
+
+            // in realtime NonUniformFFT drops the partitions its worker is late with, so it is
+            // called no faster than a host would call it
+            const auto paced = mode == "NonUniformFFT" && scenario != "offline";
+            auto nextBlockTime = Time::getMillisecondCounterHiRes ();
+
+            auto process = [&] (const dsp::ProcessContextReplacing<float>& context)
+            {
+                if (paced)
+                {
+                    while (Time::getMillisecondCounterHiRes () < nextBlockTime)
+                        Thread::sleep (1);
+
+                    // measured from now, so that a pause between calls is not made up for with a burst
+                    nextBlockTime = jmax (nextBlockTime, Time::getMillisecondCounterHiRes ())
+                                  + 1000.0 * (double)context.getOutputBlock ().getNumSamples () / sampleRate;
+                }
+
+                if (scenario != "double")
+                {
+                    host.filter.process (context);
+                    return;
+                }
+
+                // a double precision host: the same samples, through FirFilter's double entry point
+                auto& block = context.getOutputBlock ();
+                const auto numSamples = (int)block.getNumSamples ();
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < numSamples; ++i)
+                        hostBuffer.setSample (ch, i, (double)block.getSample (ch, i));
+
+                auto hostBlock = dsp::AudioBlock<double> (hostBuffer).getSubBlock (0, (size_t)numSamples);
+                host.filter.process (dsp::ProcessContextReplacing<double> (hostBlock));
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < numSamples; ++i)
+                        block.setSample (ch, i, (float)hostBuffer.getSample (ch, i));
+            };
+            Result error;
+
+            if (scenario == "swap")
+            {
+                processInBlocks (output, 0, half, 128, false, process);
+
+                const auto oldLatency = host.getLatencySamples ();
+                host.setParameter ("Order", secondOrder);
+                waitForMessageThread ();
+
+                if (! waitForLatencyChange (host, oldLatency))
+                    error.maxError = std::numeric_limits<double>::infinity ();
+
+                processInBlocks (output, half, length, 128, false, process);
+
+                const auto secondTaps = designFirFilterTaps (secondOrder);
+                const auto secondLatency = host.getLatencySamples () - secondOrder / 2;
+                const auto settled = half + secondOrder + 1 + jmax (firstLatency, secondLatency)
+                                   + (mode == "Morph" ? roundToInt (crossfadeMilliseconds * sampleRate / 1000.0) : 0);
+
+                compare (error, output, input, 0, firstTaps, firstLatency, 0, half);
+                compare (error, output, input, 0, secondTaps, secondLatency, settled, length);
+            }
+            else if (scenario == "resize")
+            {
+                processInBlocks (output, 0, half, maxBlockSize, true, process);
+
+                // a new prepare() starts from silence again
+                host.filter.prepare ({ sampleRate, 64, (uint32)numChannels });
+                processInBlocks (output, half, length, 64, true, process);
+
+                const auto secondLatency = host.getLatencySamples () - firstOrder / 2;
+
+                compare (error, output, input, 0, firstTaps, firstLatency, 0, half);
+                compare (error, output, input, half, firstTaps, secondLatency, half, length);
+            }
+            else
+            {
+                processInBlocks (output, 0, length, maxBlockSize, true, process);
+                compare (error, output, input, 0, firstTaps, firstLatency, 0, length);
+            }
+
+            DynamicObject::Ptr result = new DynamicObject ();
+            result->setProperty ("engine", "FirFilter");
+            result->setProperty ("mode", mode);
+            result->setProperty ("scenario", scenario);
+            result->setProperty ("numTaps", firstOrder + 1);
+
+            results.add (makeResult (result, error, getErrorBudget (mode), "FirFilter, " + mode + ", " + scenario));
+        }
+    }
+}
+
+void Verification::runLatency (Array<var>& results)
+{
+    // a 20 Hz lowpass lets Multirate decimate by 128 or 256, where half a sample of an odd
+    // internal order is worth a hundred at the host rate
+    constexpr double cutoff = 20.0;
+    constexpr double toneFrequency = 5.0;
+    constexpr int blockSize = 512;
+
+    const auto period = sampleRate / toneFrequency;
+    const auto omega = MathConstants<double>::twoPi / period;
+
+    for (auto order : { 3840, 4608, 4864 })
+    {
+        std::cerr << "FirFilter, latency, order " << order << std::endl;
+
+        FilterHost host;
+        host.setParameter ("Function", "LowpassWindowMethod");
+        host.setParameter ("Order", order);
+        host.setParameter ("Frequency", cutoff);
+        host.setParameter ("WindowType", "hamming");
+        host.setParameter ("Resampling", "Multirate");
+        host.setParameter ("Phase", "Linear");
+        host.setParameter ("CrossfadeTime", 0);
+        host.setParameter ("Mode", "SIMDDirect");
+        host.setNonRealtime (false);
+
+        waitForMessageThread ();
+        host.filter.prepare ({ sampleRate, (uint32)blockSize, 1 });
+
+        double internalRate = 0.0;
+        const auto coefficients = host.filter.getActiveCoefficients (internalRate);
+        const auto latency = host.getLatencySamples ();
+
+        // the tone is settled after the latency and once more the filter's length; four whole periods are measured after that
+        const auto settled = latency + roundToInt ((double)(coefficients != nullptr ? coefficients->getFilterSize () : 0) * sampleRate / internalRate);
+        const auto numPeriods = 4;
+        const auto length = settled + roundToInt (numPeriods * period);
+
+        AudioBuffer<float> buffer (1, length);
+
+        for (int n = 0; n < length; ++n)
+            buffer.setSample (0, n, (float)(0.5 * std::sin (omega * n)));
+
+        const AudioBuffer<float> input (buffer);
+        processInBlocks (buffer, 0, length, blockSize, false, [&] (const dsp::ProcessContextReplacing<float>& context) { host.filter.process (context); });
+
+        // y[n] = a sin (omega (n - delay)), so the ratio of the two phasors turns by omega * delay
+        std::complex<double> in, out;
+
+        for (int n = length - roundToInt (numPeriods * period); n < length; ++n)
+        {
+            const auto phasor = std::polar (1.0, -omega * n);
+            in += (double)input.getSample (0, n) * phasor;
+            out += (double)buffer.getSample (0, n) * phasor;
+        }
+
+        const auto delay = std::arg (in / out) / omega;
+
+        Result error;
+        error.maxError = std::abs (std::remainder (delay - latency, period));
+        error.worstSample = length - 1;
+
+        DynamicObject::Ptr result = new DynamicObject ();
+        result->setProperty ("engine", "FirFilter");
+        result->setProperty ("mode", "SIMDDirect");
+        result->setProperty ("scenario", "latency");
+        result->setProperty ("numTaps", order + 1);
+        result->setProperty ("internalOrder", coefficients != nullptr ? (int)coefficients->getFilterOrder () : 0);
+        result->setProperty ("internalRate", internalRate);
+        result->setProperty ("latency", latency);
+        result->setProperty ("measuredDelay", latency + std::remainder (delay - latency, period));
+
+        results.add (makeResult (result, error, latencyBudget, "FirFilter, latency, order " + String (order)));
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BenchmarkEngines.h"
+
+/** Checks every engine against a double precision reference convolution.
+
+    Each run feeds three channels from silence: a few impulses, an exponential sine sweep
+    and white noise, so that mixed up or shared channel state shows up as well. The output
+    is compared with the reference, shifted by the engine's latency, and the largest error
+    is normalised by sum |h| * max |x|, the largest output the taps could produce. It must
+    stay within the engine's budget: 1e-5 for the time-domain engines, whose float sums
+    over a few thousand taps stay well below that, and 1e-4 for the FFT engines, whose
+    rounding grows with the transform size and the number of partitions.
+
+    The engines that take taps are run with four kernels: a lowpass, a half-band set, an
+    antisymmetric set and one without any symmetry, which covers every folded kernel of
+    DirectConvolution. Blocks are either all of one size or a mix of sizes up to it.
+
+    FirFilter itself is checked in every mode that is a plain convolution, through a
+    minimal AudioProcessor:
+
+        blocks      mixed block sizes, in realtime and in offline (per channel) rendering
+        swap        the order changes while processing; before the swap the output must
+                    match the old set, and one kernel length plus the crossfade after it
+                    the new one
+        resize      the host prepares again with a smaller maximum block size halfway
+
+    The latency FirFilter reports is checked with a tone through a narrow lowpass and the
+    Multirate resampling, at internal orders that are odd as well as even: the phase of the
+    output must put its delay within a sample of the report.
+
+    In realtime the NonUniformFFT mode drops partitions its worker is late with, so its
+    scenarios are called at the rate of a host; the engine on its own runs as if offline.
+
+    FirFilter redesigns on the message thread, so run() has to be called from another
+    thread while the message loop is running.
+*/
+class Verification
+{
+public:
+    struct Settings
+    {
+        StringArray engines = BenchmarkEngine::getNames ();
+        Array<int> numTaps { 1, 2, 15, 64, 255, 1024, 4095 };
+        Array<int> blockSizes { 1, 64, 512 };
+        bool includeFirFilter = true;
+    };
+
+    explicit Verification (const Settings& settings);
+
+    /** Runs every check and returns the report. Failures are listed on stderr. */
+    var run ();
+
+    bool hasPassed () const { return passed; }
+
+    static double getErrorBudget (const String& engineName);
+
+private:
+    struct Result
+    {
+        double maxError = 0.0;
+        int worstChannel = 0;
+        int worstSample = 0;
+    };
+
+    var runEngine (const String& name, const String& kernel, int numTaps, int blockSize, bool varyBlockSize);
+    void runFirFilter (Array<var>& results);
+    void runLatency (Array<var>& results);
+
+    var makeResult (DynamicObject::Ptr result, const Result& error, double budget, const String& description);
+
+    Settings settings;
+    bool passed = true;
+};
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# DESCRIPTION #
+# This Script builds the console benchmark in Benchmarks/ (Release) and runs it.
+# All arguments are passed on to the benchmark, e.g.
+#   ./Scripts/Benchmark.sh --taps=64,1024 --channels=2 --output=bench.json
+# Build output goes to stderr, so stdout only carries the JSON report.
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+BASE_DIR="$( dirname "$SCRIPT_DIR")"
+BENCHMARK_DIR="$BASE_DIR/Benchmarks"
+
+# include Helpers.sh
+. "$SCRIPT_DIR/Helpers.sh"
+
+CONFIG="Release"
+
+# keep stdout for the report
+exec 3>&1 1>&2
+
+pushd "$BASE_DIR"
+
+buildProjucer "$BASE_DIR"
+
+echo "##########################"
+echo "Resave Benchmark Jucer File"
+JUCER_FILE="$(pathToJucerFile "$BENCHMARK_DIR")"
+resave "$BASE_DIR" "$JUCER_FILE"
+echo "##########################"
+
+if [[ "$OSTYPE" == "darwin"* ]]; then
+    # macOS
+
+    pushd "$BENCHMARK_DIR/Builds/MacOSX"
+    xcodebuild -configuration $CONFIG -scheme "FIR Benchmarks - ConsoleApp" || exit 1
+    popd
+
+    BENCHMARK="$BENCHMARK_DIR/Builds/MacOSX/build/$CONFIG/FIR Benchmarks"
+elif [[ "$OSTYPE" == "linux"* ]]; then
+    # Linux
+
+    make -C "$BENCHMARK_DIR/Builds/LinuxMakefile" CONFIG=$CONFIG -j"$(nproc)" || exit 1
+
+    BENCHMARK="$BENCHMARK_DIR/Builds/LinuxMakefile/build/FIR Benchmarks"
+else
+    echo "Unsupported operating system"
+    exit 1
+fi
+
+popd
+
+"$BENCHMARK" "$@" 1>&3
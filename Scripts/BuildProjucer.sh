@@ -34,6 +34,10 @@ elif [[ "$OSTYPE" == "msys" || "$OSTYPE" == "cygwin" || "$OSTYPE" == "win32" ]];
     "$MSBUILD" Projucer.sln //p:Configuration=$CONFIG || exit 1
 
     popd
+elif [[ "$OSTYPE" == "linux"* ]]; then
+    # Linux
+
+    make -C "./Submodules/JUCE/extras/Projucer/Builds/LinuxMakefile" CONFIG=$CONFIG -j"$(nproc)" || exit 1
 else
     echo "Unsupported operating system"
 fi
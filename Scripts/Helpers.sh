@@ -11,6 +11,8 @@ function pathToProjucer ()
 
     if [ "$(uname)" == "Darwin" ]; then
         PROJUCER="$PROJUCER/MacOSX/build/Release/Projucer.app/Contents/MacOS/Projucer" # MAC OS
+    elif [ "$(uname)" == "Linux" ]; then
+        PROJUCER="$PROJUCER/LinuxMakefile/build/Projucer" # LINUX
     else
         PROJUCER="$PROJUCER/VisualStudio2022/x64/Release/App/Projucer.exe" # WINDOWS
     fi
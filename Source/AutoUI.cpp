@@ -1,9 +1,18 @@
 #include "AutoUI.h"
 
-AutoUI::AutoUI(AudioProcessor &processor)
+AutoUI::AutoUI(AudioProcessor &processor, FirFilter* filter)
 :
 processor (processor)
 {
+    if (filter != nullptr)
+    {
+        responseDisplay = std::make_unique<ResponseDisplay> (*filter);
+        addAndMakeVisible (*responseDisplay);
+
+        loadMeterDisplay = std::make_unique<LoadMeterDisplay> (filter->getLoadMeter ());
+        addAndMakeVisible (*loadMeterDisplay);
+    }
+
     addAndMakeVisible (infoButton);
     infoButton.onClick = [&](){
         AlertWindow::showMessageBoxAsync (MessageBoxIconType::InfoIcon, "Version", String (ProjectInfo::projectName) + String(" v") + String (ProjectInfo::versionString));
@@ -141,6 +150,12 @@ void AutoUI::paint(Graphics &g)
 void AutoUI::resized()
 {
     auto area = getLocalBounds ().reduced (8);
+
+    if (loadMeterDisplay != nullptr)
+        loadMeterDisplay->setBounds (area.removeFromBottom (56));
+
+    if (responseDisplay != nullptr)
+        responseDisplay->setBounds (area.removeFromBottom (area.getHeight () * 2 / 5));
     auto leftArea = area.removeFromLeft (150);
 
     infoButton.setBounds (leftArea.withSize (25, 25).reduced (1));
@@ -149,3 +164,199 @@ void AutoUI::resized()
     for (auto c : components)
         c->setBounds (area.removeFromTop (h));
 }
+
+//==============================================================================
+LoadMeterDisplay::LoadMeterDisplay (LoadMeter& m)
+    : meter (m)
+{
+    addAndMakeVisible (saveButton);
+    addAndMakeVisible (resetButton);
+
+    saveButton.onClick = [this] () { save (); };
+    resetButton.onClick = [this] () { meter.reset (); };
+
+    startTimerHz (4);
+}
+
+void LoadMeterDisplay::timerCallback ()
+{
+    snapshot = meter.getSnapshot ();
+    repaint ();
+}
+
+void LoadMeterDisplay::save ()
+{
+    fileChooser = std::make_unique<FileChooser> ("Save the DSP load", File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("FIR load.json"), "*.json");
+
+    fileChooser->launchAsync (FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting,
+                              [this] (const FileChooser& chooser)
+    {
+        const auto file = chooser.getResult ();
+
+        if (file != File () && ! meter.writeTo (file))
+            AlertWindow::showMessageBoxAsync (MessageBoxIconType::WarningIcon, "DSP load", "Cannot write " + file.getFullPathName ());
+    });
+}
+
+void LoadMeterDisplay::paint (Graphics& g)
+{
+    const auto percent = [] (double load) { return String (load * 100.0, 1) + "%"; };
+
+    String loads = "load  mean " + percent (snapshot.meanLoad);
+
+    for (size_t i = 0; i < snapshot.loadPercentiles.size (); ++i)
+        loads << "  " << LoadMeter::getPercentileName (i) << " " << percent (snapshot.loadPercentiles[i]);
+
+    loads << "  max " << percent (snapshot.maxLoad);
+
+    const auto blocks = String (snapshot.numBlocks) + " blocks, " + String (snapshot.numOverruns) + " over the deadline";
+    const auto swaps = String (snapshot.numSwaps) + " swaps, mean " + String (snapshot.meanSwapMicroseconds, 1)
+                     + " us, max " + String (snapshot.maxSwapMicroseconds, 1) + " us";
+
+    g.setColour (snapshot.numOverruns > 0 ? Colours::orange : Colours::lightgrey);
+    g.setFont (FontOptions (12.0f));
+
+    auto area = getLocalBounds ().withTrimmedRight (saveButton.getWidth () + 4);
+    const auto lineHeight = area.getHeight () / 3;
+
+    for (auto& line : { loads, blocks, swaps })
+        g.drawFittedText (line, area.removeFromTop (lineHeight), Justification::centredLeft, 1);
+}
+
+void LoadMeterDisplay::resized ()
+{
+    auto area = getLocalBounds ().removeFromRight (60);
+
+    saveButton.setBounds (area.removeFromTop (area.getHeight () / 2).reduced (1));
+    resetButton.setBounds (area.reduced (1));
+}
+
+//==============================================================================
+ResponseDisplay::ResponseDisplay (FirFilter& f)
+    : filter (f)
+{
+    viewSelector.addItem ("Magnitude", magnitude);
+    viewSelector.addItem ("Phase", phase);
+    viewSelector.addItem ("Group delay", groupDelay);
+    viewSelector.setSelectedId (magnitude, dontSendNotification);
+    viewSelector.onChange = [this] () { repaint (); };
+    addAndMakeVisible (viewSelector);
+
+    startTimerHz (30);
+}
+
+void ResponseDisplay::timerCallback ()
+{
+    if (analyser.getCurves (curves))
+        repaint ();
+}
+
+Path ResponseDisplay::createPath (const std::vector<float>& frequencies, const std::vector<float>& values, float minValue, float maxValue) const
+{
+    Path path;
+    auto started = false;
+
+    for (size_t i = 0; i < jmin (frequencies.size (), values.size ()); ++i)
+    {
+        const auto frequency = frequencies[i];
+
+        if (frequency < 20.f || frequency > maxFrequency)
+            continue;
+
+        // gaps, such as the group delay in the stop band, break the line
+        if (std::isnan (values[i]))
+        {
+            started = false;
+            continue;
+        }
+
+        const auto x = plotArea.getX () + plotArea.getWidth () * std::log (frequency / 20.f) / std::log (maxFrequency / 20.f);
+        const auto y = jmap (jlimit (minValue, maxValue, values[i]), minValue, maxValue, plotArea.getBottom (), plotArea.getY ());
+
+        if (started)
+            path.lineTo (x, y);
+        else
+            path.startNewSubPath (x, y);
+
+        started = true;
+    }
+
+    return path;
+}
+
+void ResponseDisplay::paint (Graphics& g)
+{
+    g.fillAll (Colours::black.withAlpha (0.6f));
+
+    maxFrequency = jmax (1000.f, (float)filter.getSampleRate () / 2.f);
+
+    const auto view = viewSelector.getSelectedId ();
+    auto minValue = -120.f, maxValue = 12.f;
+    String unit = "dB";
+
+    if (view == phase)
+    {
+        minValue = -MathConstants<float>::pi;
+        maxValue = MathConstants<float>::pi;
+        unit = "rad";
+    }
+    else if (view == groupDelay)
+    {
+        minValue = 0.f;
+        maxValue = 1.f;
+        unit = "ms";
+
+        for (auto delay : curves.groupDelayMilliseconds)
+            if (! std::isnan (delay))
+                maxValue = jmax (maxValue, delay * 1.1f);
+    }
+
+    // decades across, a few value lines up
+    g.setFont (FontOptions (10.0f));
+
+    for (auto frequency : { 100.f, 1000.f, 10000.f })
+    {
+        const auto x = plotArea.getX () + plotArea.getWidth () * std::log (frequency / 20.f) / std::log (maxFrequency / 20.f);
+
+        g.setColour (Colours::grey.withAlpha (0.4f));
+        g.drawVerticalLine (roundToInt (x), plotArea.getY (), plotArea.getBottom ());
+        g.setColour (Colours::grey);
+        g.drawText (frequency < 1000.f ? String (frequency, 0) : String (frequency / 1000.f, 0) + "k", Rectangle<float> (x + 2.f, plotArea.getBottom () - 12.f, 30.f, 12.f), Justification::centredLeft);
+    }
+
+    for (int line = 0; line <= 4; ++line)
+    {
+        const auto value = minValue + (maxValue - minValue) * (float)line / 4.f;
+        const auto y = jmap (value, minValue, maxValue, plotArea.getBottom (), plotArea.getY ());
+
+        g.setColour (Colours::grey.withAlpha (0.4f));
+        g.drawHorizontalLine (roundToInt (y), plotArea.getX (), plotArea.getRight ());
+        g.setColour (Colours::grey);
+        g.drawText (String (value, view == phase ? 1 : 0) + " " + unit, Rectangle<float> (plotArea.getX () + 2.f, y - 12.f, 60.f, 12.f), Justification::centredLeft);
+    }
+
+    if (view == magnitude)
+    {
+        g.setColour (Colours::skyblue.withAlpha (0.5f));
+        g.strokePath (createPath (curves.spectrumFrequencies, curves.inputDecibels, minValue, maxValue), PathStrokeType (1.0f));
+        g.setColour (Colours::lightgreen.withAlpha (0.7f));
+        g.strokePath (createPath (curves.spectrumFrequencies, curves.outputDecibels, minValue, maxValue), PathStrokeType (1.0f));
+    }
+
+    const auto& response = view == magnitude ? curves.magnitudeDecibels : (view == phase ? curves.phase : curves.groupDelayMilliseconds);
+
+    g.setColour (Colours::orange);
+
+    if (curves.responseFrequencies.empty ())
+        g.drawText ("no single coefficient set in this mode", plotArea, Justification::centred);
+    else
+        g.strokePath (createPath (curves.responseFrequencies, response, minValue, maxValue), PathStrokeType (1.5f));
+}
+
+void ResponseDisplay::resized ()
+{
+    auto area = getLocalBounds ();
+
+    viewSelector.setBounds (area.removeFromTop (22).removeFromRight (120).reduced (1));
+    plotArea = area.reduced (2).toFloat ();
+}
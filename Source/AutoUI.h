@@ -1,11 +1,73 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "Filter.h"
+#include "ResponseAnalyser.h"
+
+/** Shows a LoadMeter's snapshot a few times a second, with buttons to save it as JSON and to
+    start over.
+*/
+class LoadMeterDisplay : public juce::Component, private Timer
+{
+public:
+    LoadMeterDisplay (LoadMeter& meter);
+
+    void paint (Graphics& g) override;
+    void resized () override;
+
+private:
+    void timerCallback () override;
+    void save ();
+
+    LoadMeter& meter;
+    LoadMeter::Snapshot snapshot;
+
+    TextButton saveButton { "Save" };
+    TextButton resetButton { "Reset" };
+    std::unique_ptr<FileChooser> fileChooser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadMeterDisplay)
+};
+
+/** Plots the filter's magnitude, phase or group delay over its live input and output
+    spectra. The curves come from a ResponseAnalyser and are redrawn at most 30 times a second.
+*/
+class ResponseDisplay : public juce::Component, private Timer
+{
+public:
+    ResponseDisplay (FirFilter& filter);
+
+    void paint (Graphics& g) override;
+    void resized () override;
+
+private:
+    enum View
+    {
+        magnitude = 1,
+        phase,
+        groupDelay
+    };
+
+    void timerCallback () override;
+    Path createPath (const std::vector<float>& frequencies, const std::vector<float>& values, float minValue, float maxValue) const;
+
+    FirFilter& filter;
+    ResponseAnalyser analyser { filter };
+    ResponseAnalyser::Curves curves;
+
+    Rectangle<float> plotArea;
+    float maxFrequency = 22050.f;
+
+    ComboBox viewSelector;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseDisplay)
+};
 
 class AutoUI : public juce::Component
 {
 public:
-    AutoUI (AudioProcessor& processor);
+    /** Shows the filter's response and processing load below the parameters when a filter is given. */
+    AutoUI (AudioProcessor& processor, FirFilter* filter = nullptr);
 
     void paint (Graphics& g) override;
     void resized () override;
@@ -20,6 +82,8 @@ private:
     String lastName;
     
     TextButton infoButton { "i", "Info" };
+    std::unique_ptr<ResponseDisplay> responseDisplay;
+    std::unique_ptr<LoadMeterDisplay> loadMeterDisplay;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoUI)
 };
\ No newline at end of file
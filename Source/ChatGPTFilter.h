@@ -10,7 +10,7 @@ public:
 
     std::vector<std::vector<float>> ringBuffer;
     int ringBufferSize = 0;
-    int ringBufferPos = 0;
+    std::vector<int> ringBufferPos; // eine Schreibposition pro Kanal
 
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
@@ -19,7 +19,7 @@ public:
 
         int numChannels = static_cast<int>(spec.numChannels);
         ringBufferSize = 8192; // größer als max. Taps + Blockgröße
-        ringBufferPos = 0;
+        ringBufferPos.assign(numChannels, 0);
 
         ringBuffer.resize(numChannels);
         for (auto& buf : ringBuffer)
@@ -41,6 +41,11 @@ public:
         reset();
     }
 
+    const std::vector<float>& getCoefficients() const
+    {
+        return coeffs;
+    }
+
     void process(const juce::dsp::ProcessContextReplacing<float>& context)
     {
         auto& inputBlock = context.getInputBlock();
@@ -49,31 +54,30 @@ public:
         auto numSamples = inputBlock.getNumSamples();
     
         const int filterLength = static_cast<int>(coeffs.size());
-        const int halfLength = filterLength / 2;
     
         for (size_t ch = 0; ch < numChannels; ++ch)
         {
             auto* in = inputBlock.getChannelPointer(ch);
             auto* out = outputBlock.getChannelPointer(ch);
+            int& pos = ringBufferPos[ch];
     
             for (int n = 0; n < static_cast<int>(numSamples); ++n)
             {
                 // Ringpuffer schreiben
-                ringBuffer[ch][ringBufferPos] = in[n];
+                ringBuffer[ch][pos] = in[n];
     
                 // Faltung mit symmetrischer Impulsantwort
                 float acc = 0.0f;
                 for (int k = 0; k < filterLength; ++k)
                 {
-                    int index = (ringBufferPos - k + ringBufferSize) % ringBufferSize;
+                    int index = (pos - k + ringBufferSize) % ringBufferSize;
                     acc += coeffs[k] * ringBuffer[ch][index];
                 }
     
-                // Output wird verzögert um M/2 Samples (linear phase)
-                int outIndex = (ringBufferPos - halfLength + ringBufferSize) % ringBufferSize;
+                // Output ist durch die symmetrische Impulsantwort um M/2 Samples verzögert (linear phase)
                 out[n] = acc;
     
-                ringBufferPos = (ringBufferPos + 1) % ringBufferSize;
+                pos = (pos + 1) % ringBufferSize;
             }
         }
     }
@@ -0,0 +1,261 @@
+#include "ConvolutionPlanner.h"
+#include "DirectConvolution.h"
+#include "PartitionedConvolution.h"
+#include "InterleavedConvolution.h"
+
+namespace
+{
+    constexpr int benchmarkNumTaps = 256;
+    constexpr int benchmarkNumSamples = 16384;
+    constexpr int benchmarkNumRuns = 3;
+
+    /** Channel count from which the interleaved engine is considered. */
+    constexpr int minInterleavedChannels = 4;
+
+    /** Runs processor over benchmarkNumSamples of noise and returns the best time per sample and channel in ns. */
+    template <typename Processor>
+    double measureNanosecondsPerSample (Processor& processor, int blockSize, int numChannels = 1)
+    {
+        AudioBuffer<float> buffer (numChannels, blockSize);
+        Random random (0x5eed);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, random.nextFloat () * 2.f - 1.f);
+
+        dsp::AudioBlock<float> block (buffer);
+        auto best = std::numeric_limits<double>::max ();
+
+        for (int run = 0; run < benchmarkNumRuns; ++run)
+        {
+            const auto start = Time::getHighResolutionTicks ();
+
+            for (int done = 0; done < benchmarkNumSamples; done += blockSize)
+                processor.process (dsp::ProcessContextReplacing<float> (block));
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks () - start);
+            best = jmin (best, seconds * 1.0e9 / benchmarkNumSamples / numChannels);
+        }
+
+        return best;
+    }
+
+    dsp::FIR::Coefficients<float>::Ptr createBenchmarkCoefficients (int numTaps)
+    {
+        dsp::FIR::Coefficients<float>::Ptr coefficients = new dsp::FIR::Coefficients<float> ((size_t)numTaps);
+
+        for (int i = 0; i < numTaps; ++i)
+            coefficients->getRawCoefficients ()[i] = 1.f / (float)numTaps;
+
+        return coefficients;
+    }
+
+    CriticalSection& getCacheLock ()
+    {
+        static CriticalSection lock;
+        return lock;
+    }
+
+    /** Keyed by block size and partition size. */
+    std::map<std::pair<int, int>, ConvolutionPlanner::Calibration>& getMemoryCache ()
+    {
+        static std::map<std::pair<int, int>, ConvolutionPlanner::Calibration> cache;
+        return cache;
+    }
+}
+
+void ConvolutionPlanner::prepare (const dsp::ProcessSpec& spec)
+{
+    const auto blockSize = (int)spec.maximumBlockSize;
+    partitionSize = UniformPartitionedConvolution::getPartitionSizeForBlockSize (blockSize);
+    numChannels = jmax (1, (int)spec.numChannels);
+
+    const ScopedLock sl (getCacheLock ());
+    auto& cache = getMemoryCache ();
+    const auto key = std::make_pair (blockSize, partitionSize);
+
+    if (auto it = cache.find (key); it != cache.end ())
+    {
+        calibration = it->second;
+        return;
+    }
+
+    if (! loadFromCacheFile (blockSize, partitionSize, calibration))
+    {
+        calibration = measure (blockSize, partitionSize);
+        saveToCacheFile (blockSize, partitionSize, calibration);
+    }
+
+    cache[key] = calibration;
+}
+
+ConvolutionPlanner::Strategy ConvolutionPlanner::choose (int numTaps, DirectConvolution::Symmetry symmetry, bool allowLatency,
+                                                         std::optional<Strategy> current) const
+{
+    if (partitionSize == 0)
+        return Strategy::direct;
+
+    const auto numPartitions = (numTaps + partitionSize - 1) / partitionSize;
+
+    const auto direct = calibration.directPerTap * numTaps;
+    auto simdDirect = calibration.simdDirectPerTap * numTaps;
+
+    if (symmetry == DirectConvolution::Symmetry::symmetric || symmetry == DirectConvolution::Symmetry::antisymmetric)
+        simdDirect = calibration.foldedDirectPerTap * numTaps;
+    else if (symmetry == DirectConvolution::Symmetry::halfBand)
+        simdDirect = calibration.foldedDirectPerTap * (numTaps + 1) / 2;
+
+    // the partitioned engine adds a partition of latency, which only the caller can weigh up
+    const auto partitioned = allowLatency ? calibration.fftPerFrame + calibration.fftPerPartition * numPartitions
+                                          : std::numeric_limits<double>::max ();
+
+    auto interleaved = std::numeric_limits<double>::max ();
+
+    if (numChannels >= minInterleavedChannels)
+    {
+        // a group that does not fill its power of two stride wastes the unused lanes
+        const auto groupSize = jmin (numChannels, InterleavedConvolution::maxGroupSize);
+        interleaved = calibration.interleavedPerTap * numTaps * nextPowerOfTwo (groupSize) / groupSize;
+    }
+
+    auto getCost = [&] (Strategy strategy)
+    {
+        switch (strategy)
+        {
+            case Strategy::direct:          return direct;
+            case Strategy::simdDirect:      return simdDirect;
+            case Strategy::partitionedFFT:  return partitioned;
+            case Strategy::interleavedSIMD: return interleaved;
+        }
+
+        return direct;
+    };
+
+    const auto best = jmin (direct, simdDirect, partitioned, interleaved);
+
+    if (current.has_value () && getCost (*current) * (1.0 - switchingMargin) <= best)
+        return *current;
+
+    if (best == partitioned)
+        return Strategy::partitionedFFT;
+
+    if (best == interleaved)
+        return Strategy::interleavedSIMD;
+
+    return simdDirect < direct ? Strategy::simdDirect : Strategy::direct;
+}
+
+ConvolutionPlanner::Calibration ConvolutionPlanner::measure (int blockSize, int size)
+{
+    const dsp::ProcessSpec spec { 48000.0, (uint32)blockSize, 1 };
+    Calibration result;
+
+    {
+        dsp::FIR::Filter<float> filter (createBenchmarkCoefficients (benchmarkNumTaps));
+        filter.prepare (spec);
+        result.directPerTap = measureNanosecondsPerSample (filter, blockSize) / benchmarkNumTaps;
+    }
+
+    {
+        DirectConvolution convolution;
+        convolution.prepare (spec, benchmarkNumTaps);
+        convolution.setCoefficients (createBenchmarkCoefficients (benchmarkNumTaps));
+        result.simdDirectPerTap = measureNanosecondsPerSample (convolution, blockSize) / benchmarkNumTaps;
+
+        convolution.setCoefficients (createBenchmarkCoefficients (benchmarkNumTaps), DirectConvolution::Symmetry::symmetric);
+        result.foldedDirectPerTap = measureNanosecondsPerSample (convolution, blockSize) / benchmarkNumTaps;
+    }
+
+    {
+        const auto groupSize = InterleavedConvolution::maxGroupSize;
+        const dsp::ProcessSpec groupSpec { spec.sampleRate, spec.maximumBlockSize, (uint32)groupSize };
+
+        InterleavedConvolution convolution;
+        convolution.prepare (groupSpec, benchmarkNumTaps);
+        convolution.setCoefficients (convolution.createExpandedCoefficients (*createBenchmarkCoefficients (benchmarkNumTaps)));
+        result.interleavedPerTap = measureNanosecondsPerSample (convolution, blockSize, groupSize) / benchmarkNumTaps;
+    }
+
+    {
+        // two measurements separate the transform cost from the per-partition multiply-add
+        constexpr int manyPartitions = 9;
+
+        auto measurePartitions = [&] (int numPartitions)
+        {
+            auto coefficients = createBenchmarkCoefficients (numPartitions * size);
+
+            UniformPartitionedConvolution convolution;
+            convolution.prepare (spec, size, numPartitions * size);
+            convolution.setImpulseResponse (new PartitionedImpulseResponse (coefficients->getRawCoefficients (), numPartitions * size, size));
+            return measureNanosecondsPerSample (convolution, blockSize);
+        };
+
+        const auto one = measurePartitions (1);
+        const auto many = measurePartitions (manyPartitions);
+
+        result.fftPerPartition = jmax (0.0, (many - one) / (manyPartitions - 1));
+        result.fftPerFrame = jmax (0.0, one - result.fftPerPartition);
+    }
+
+    return result;
+}
+
+//==============================================================================
+File ConvolutionPlanner::getCacheFile ()
+{
+    return File::getSpecialLocation (File::userApplicationDataDirectory)
+        .getChildFile (ProjectInfo::projectName)
+        .getChildFile ("ConvolutionPlanner.xml");
+}
+
+bool ConvolutionPlanner::loadFromCacheFile (int blockSize, int size, Calibration& result)
+{
+    auto xml = parseXML (getCacheFile ());
+
+    // numbers measured on a different CPU are worthless
+    if (xml == nullptr || xml->getStringAttribute ("cpu") != SystemStats::getCpuModel ())
+        return false;
+
+    for (auto* entry : xml->getChildWithTagNameIterator ("Calibration"))
+    {
+        // entries written before the block size was recorded are measured again
+        if (entry->getIntAttribute ("blockSize") != blockSize || entry->getIntAttribute ("partitionSize") != size
+            || ! entry->hasAttribute ("interleavedPerTap"))
+            continue;
+
+        result.directPerTap = entry->getDoubleAttribute ("directPerTap");
+        result.simdDirectPerTap = entry->getDoubleAttribute ("simdDirectPerTap");
+        result.foldedDirectPerTap = entry->getDoubleAttribute ("foldedDirectPerTap");
+        result.fftPerFrame = entry->getDoubleAttribute ("fftPerFrame");
+        result.fftPerPartition = entry->getDoubleAttribute ("fftPerPartition");
+        result.interleavedPerTap = entry->getDoubleAttribute ("interleavedPerTap");
+        return true;
+    }
+
+    return false;
+}
+
+void ConvolutionPlanner::saveToCacheFile (int blockSize, int size, const Calibration& result)
+{
+    auto file = getCacheFile ();
+    auto xml = parseXML (file);
+
+    if (xml == nullptr || xml->getStringAttribute ("cpu") != SystemStats::getCpuModel ())
+    {
+        xml = std::make_unique<XmlElement> ("ConvolutionPlanner");
+        xml->setAttribute ("cpu", SystemStats::getCpuModel ());
+    }
+
+    auto* entry = xml->createNewChildElement ("Calibration");
+    entry->setAttribute ("blockSize", blockSize);
+    entry->setAttribute ("partitionSize", size);
+    entry->setAttribute ("directPerTap", result.directPerTap);
+    entry->setAttribute ("simdDirectPerTap", result.simdDirectPerTap);
+    entry->setAttribute ("foldedDirectPerTap", result.foldedDirectPerTap);
+    entry->setAttribute ("fftPerFrame", result.fftPerFrame);
+    entry->setAttribute ("fftPerPartition", result.fftPerPartition);
+    entry->setAttribute ("interleavedPerTap", result.interleavedPerTap);
+
+    file.getParentDirectory ().createDirectory ();
+    xml->writeTo (file);
+}
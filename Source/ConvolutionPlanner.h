@@ -0,0 +1,74 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DirectConvolution.h"
+
+/** Chooses the cheapest convolution engine for a coefficient set.
+
+    prepare() looks up how fast each engine runs on this machine for the given block size.
+    The numbers come from a short micro-benchmark that is run once and then kept both in
+    memory and in the user's application data folder, so only the very first instance on a
+    machine pays for it. The direct engines are timed at the block size and the FFT at the
+    partition size, so the numbers are kept per pair of both. choose() then compares the
+    predicted cost per sample:
+
+        direct          directPerTap * numTaps
+        SIMD direct     simdDirectPerTap * numTaps, or foldedDirectPerTap * numTaps when linear
+                        phase and foldedDirectPerTap * numTaps / 2 for half-band sets
+        partitioned     fftPerFrame + fftPerPartition * numPartitions
+        interleaved     interleavedPerTap * numTaps * stride / numChannels, for 4 channels or
+                        more, where stride is the channel count rounded up to a power of two
+
+    The interleaved kernel loads every coefficient once for a whole group of channels, so
+    on surround and Ambisonic layouts it usually beats running the channels one by one.
+
+    The partitioned engine delays the output by a partition, so it is only a candidate when
+    the caller accepts that latency. A change of engine resets the convolution history and
+    may change the latency, so near a break-even point the current engine is kept until
+    another one is clearly cheaper.
+*/
+class ConvolutionPlanner
+{
+public:
+    enum class Strategy
+    {
+        direct,
+        simdDirect,
+        partitionedFFT,
+        interleavedSIMD
+    };
+
+    /** Measured costs, all in nanoseconds per output sample and channel. */
+    struct Calibration
+    {
+        double directPerTap = 0.0;
+        double simdDirectPerTap = 0.0;
+        double foldedDirectPerTap = 0.0;
+        double fftPerFrame = 0.0;
+        double fftPerPartition = 0.0;
+        double interleavedPerTap = 0.0;    // with a full group of channels
+    };
+
+    void prepare (const dsp::ProcessSpec& spec);
+
+    /** Returns the cheapest strategy for the coefficients. current is the strategy the previous
+        set runs with, if any; it is kept unless another one is more than switchingMargin cheaper.
+    */
+    Strategy choose (int numTaps, DirectConvolution::Symmetry symmetry, bool allowLatency,
+                     std::optional<Strategy> current = {}) const;
+
+    /** How much cheaper, as a fraction of the current strategy's cost, another one has to be to replace it. */
+    static constexpr double switchingMargin = 0.25;
+
+    const Calibration& getCalibration () const { return calibration; }
+
+private:
+    static Calibration measure (int maximumBlockSize, int partitionSize);
+    static File getCacheFile ();
+    static bool loadFromCacheFile (int blockSize, int partitionSize, Calibration& result);
+    static void saveToCacheFile (int blockSize, int partitionSize, const Calibration& result);
+
+    Calibration calibration;
+    int partitionSize = 0;
+    int numChannels = 1;
+};
@@ -0,0 +1,114 @@
+#include "DesignCache.h"
+
+bool DesignCache::Key::operator== (const Key& other) const
+{
+    return function == other.function
+        && order == other.order
+        && frequency == other.frequency
+        && sampleRate == other.sampleRate
+        && windowType == other.windowType
+        && transitionWidth == other.transitionWidth
+        && amplitude == other.amplitude
+        && spline == other.spline
+        && stopBandWeight == other.stopBandWeight
+        && minimumPhase == other.minimumPhase;
+}
+
+size_t DesignCache::KeyHash::operator() (const Key& key) const
+{
+    size_t seed = 0;
+
+    auto combine = [&seed] (auto value)
+    {
+        seed ^= std::hash<decltype (value)>() (value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+
+    combine (key.function);
+    combine (key.order);
+    combine (key.frequency);
+    combine (key.sampleRate);
+    combine (key.windowType);
+    combine (key.transitionWidth);
+    combine (key.amplitude);
+    combine (key.spline);
+    combine (key.stopBandWeight);
+    combine (key.minimumPhase);
+
+    return seed;
+}
+
+//==============================================================================
+DesignCache::DesignCache (size_t maxSizeInBytes)
+    : maxSize (maxSizeInBytes)
+{
+}
+
+bool DesignCache::lookup (const Key& key, Entry& result)
+{
+    auto it = index.find (key);
+
+    if (it == index.end ())
+        return false;
+
+    entries.splice (entries.begin (), entries, it->second);
+    result = it->second->second;
+    return true;
+}
+
+void DesignCache::store (const Key& key, const Entry& entry)
+{
+    if (auto it = index.find (key); it != index.end ())
+        evict (it->second);
+
+    const auto size = getSizeInBytes (entry);
+
+    // a single entry over budget would only push out everything else
+    if (size > maxSize)
+        return;
+
+    entries.emplace_front (key, entry);
+    index[key] = entries.begin ();
+    sizeInBytes += size;
+
+    while (sizeInBytes > maxSize)
+        evict (std::prev (entries.end ()));
+}
+
+void DesignCache::clear ()
+{
+    entries.clear ();
+    index.clear ();
+    sizeInBytes = 0;
+}
+
+size_t DesignCache::getSizeInBytes (const Entry& entry)
+{
+    auto spectrumSize = [] (const PartitionedImpulseResponse* ir)
+    {
+        return ir != nullptr ? (size_t)ir->numPartitions * 2 * (size_t)ir->numBins * sizeof (float) : 0;
+    };
+
+    auto size = sizeof (Entry);
+
+    if (entry.coefficients != nullptr)
+        size += entry.coefficients->getFilterSize () * sizeof (float);
+
+    size += spectrumSize (entry.impulseResponse.get ());
+
+    if (auto* nonUniform = entry.nonUniformImpulseResponse.get ())
+    {
+        size += (size_t)NonUniformPartitionedConvolution::headSize * sizeof (float);
+
+        for (auto& segment : nonUniform->segments)
+            size += spectrumSize (segment.get ());
+    }
+
+    return size;
+}
+
+void DesignCache::evict (List::iterator it)
+{
+    sizeInBytes -= getSizeInBytes (it->second);
+    index.erase (it->first);
+    entries.erase (it);
+}
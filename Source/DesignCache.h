@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DirectConvolution.h"
+#include "PartitionedConvolution.h"
+#include "NonUniformConvolution.h"
+
+/** Least recently used cache of designed coefficient sets.
+
+    Sweeping a parameter back and forth or recalling presets keeps asking for the same
+    designs. Each entry keeps the coefficients, their symmetry and, once an FFT engine has
+    needed them, the partition spectra, so a repeated design costs one hash lookup instead
+    of a redesign plus a set of FFTs. The total size of all entries is kept below a memory
+    budget by evicting the least recently used ones.
+
+    Not thread safe; FirFilter only uses it while holding its design lock.
+*/
+class DesignCache
+{
+public:
+    /** Everything a design depends on. Fields the design function ignores should be left at 0. */
+    struct Key
+    {
+        int function = 0;
+        int order = 0;
+        float frequency = 0.f;
+        double sampleRate = 0.0;
+        int windowType = 0;
+        float transitionWidth = 0.f;
+        float amplitude = 0.f;
+        float spline = 0.f;
+        float stopBandWeight = 0.f;
+        bool minimumPhase = false;
+
+        bool operator== (const Key& other) const;
+    };
+
+    struct Entry
+    {
+        dsp::FIR::Coefficients<float>::Ptr coefficients;
+        DirectConvolution::Symmetry symmetry = DirectConvolution::Symmetry::none;
+        PartitionedImpulseResponse::Ptr impulseResponse;
+        NonUniformImpulseResponse::Ptr nonUniformImpulseResponse;
+    };
+
+    explicit DesignCache (size_t maxSizeInBytes = 64 * 1024 * 1024);
+
+    /** Copies the entry for key into result and marks it as most recently used. */
+    bool lookup (const Key& key, Entry& result);
+
+    /** Adds or replaces the entry for key, then evicts old entries until the budget is met. */
+    void store (const Key& key, const Entry& entry);
+
+    void clear ();
+
+    size_t getSizeInBytes () const { return sizeInBytes; }
+    int getNumEntries () const { return (int)entries.size (); }
+
+private:
+    struct KeyHash
+    {
+        size_t operator() (const Key& key) const;
+    };
+
+    using List = std::list<std::pair<Key, Entry>>;
+
+    static size_t getSizeInBytes (const Entry& entry);
+    void evict (List::iterator it);
+
+    List entries;  // most recently used first
+    std::unordered_map<Key, List::iterator, KeyHash> index;
+
+    size_t maxSize;
+    size_t sizeInBytes = 0;
+};
@@ -1,6 +1,11 @@
 #pragma once
+#include <JuceHeader.h>
+#include "DirectConvolution.h"
 #include <stdint.h>
 #include <vector>
+#include <map>
+#include <memory>
+#include <tuple>
 #include <cstring>
 #include <math.h>
 
@@ -8,10 +13,6 @@
 #define M_PI 3.14159265358979323846  /* pi */
 #endif // !M_PI
 
-#define NUM_BESSELI0_ITERATIONS 32
-#define NUM_LNGAMMA_ITERATIONS (256)
-#define EULER_GAMMA            (0.57721566490153286)
-
 namespace DigitalFilter
 {
    enum FIRFilterType
@@ -39,13 +40,169 @@ namespace DigitalFilter
    };
 
 
+   /// @brief Window tables shared by every FIRFilter design.
+   /// @details A table is computed once per window type, length and (for Kaiser) beta, and
+   /// reused by all later designs with the same window. The sine and cosine-sum windows are built
+   /// from an eight-lane rotation recurrence and Chebyshev polynomials instead of one cos() per
+   /// term and tap, and Kaiser uses a polynomial approximation of I0, evaluated once for the
+   /// denominator.
+   class WindowTables
+   {
+   public:
+    using Table = std::shared_ptr<const std::vector<float>>;
+
+    static Table get(FIRFilterWindowType type, int length, float beta) {
+     static juce::CriticalSection lock;
+     static std::map<std::tuple<int, int, float>, Table> tables;
+
+     const auto key = std::make_tuple((int)type, length, beta);
+     const juce::ScopedLock sl(lock);
+
+     if (auto it = tables.find(key); it != tables.end())
+      return it->second;
+
+     // designs that have gone out of use are not tracked, so keep the number of tables bounded
+     if (tables.size() >= maxNumTables)
+      tables.clear();
+
+     return tables[key] = std::make_shared<const std::vector<float>>(compute(type, length, beta));
+    }
+
+    /// @brief Modified Bessel function of the first kind, order 0 (Abramowitz & Stegun 9.8.1 and 9.8.2).
+    /// @details Relative error below 2e-7, which is the precision of the float taps anyway.
+    static double besselI0(double x) {
+     x = std::abs(x);
+
+     if (x < 3.75) {
+      const auto t = (x / 3.75) * (x / 3.75);
+      return 1.0 + t * (3.5156229 + t * (3.0899424 + t * (1.2067492 + t * (0.2659732 + t * (0.0360768 + t * 0.0045813)))));
+     }
+
+     const auto t = 3.75 / x;
+     return (exp(x) / sqrt(x)) * (0.39894228 + t * (0.01328592 + t * (0.00225319 + t * (-0.00157565 + t * (0.00916281
+            + t * (-0.02057706 + t * (0.02635537 + t * (-0.01647633 + t * 0.00392377))))))));
+    }
+
+   private:
+    static constexpr size_t maxNumTables = 32;
+
+    /// @brief Calls write(n, cos (x n), sin (x n)) for every n below length.
+    /// @details Rotates eight phasors at once and recomputes them every few thousand taps, the
+    /// same way FIRFilter::addSinc does.
+    template <typename Write>
+    static void forEachPhasor(double x, int length, Write&& write) {
+     constexpr int numLanes = 8;
+     constexpr int resyncInterval = 4096;
+
+     const auto stepCos = cos(numLanes * x);
+     const auto stepSin = sin(numLanes * x);
+
+     double c[numLanes], s[numLanes];
+
+     for (int start = 0; start < length; start += numLanes) {
+      if (start % resyncInterval == 0) {
+       for (int lane = 0; lane < numLanes; lane++) {
+        c[lane] = cos(x * (start + lane));
+        s[lane] = sin(x * (start + lane));
+       }
+      }
+
+      const auto numThisTime = std::min(numLanes, length - start);
+
+      for (int lane = 0; lane < numThisTime; lane++)
+       write(start + lane, c[lane], s[lane]);
+
+      for (int lane = 0; lane < numLanes; lane++) {
+       const auto nextSin = s[lane] * stepCos + c[lane] * stepSin;
+       c[lane] = c[lane] * stepCos - s[lane] * stepSin;
+       s[lane] = nextSin;
+      }
+     }
+    }
+
+    static std::vector<float> compute(FIRFilterWindowType type, int length, float beta) {
+     std::vector<float> window((size_t)length, 1.0f);
+
+     if (length < 2)
+      return window;
+
+     // every window is symmetric about the sinc's centre tap length / 2, so odd lengths give
+     // symmetric (linear-phase) designs; N is the window's period, length - 1 for those
+     const auto centre = (double)(length / 2);
+     const auto N = 2.0 * centre;
+
+     // a0 - a1 cos (x) + a2 cos (2x) - a3 cos (3x) + a4 cos (4x), with x = 2 pi n / N
+     auto cosineSum = [&](double a0, double a1, double a2, double a3, double a4) {
+      forEachPhasor(2.0 * M_PI / N, length, [&](int n, double c, double) {
+       const auto c2 = 2.0 * c * c - 1.0;
+       const auto c3 = 2.0 * c * c2 - c;
+       const auto c4 = 2.0 * c * c3 - c2;
+       window[(size_t)n] = static_cast<float>(a0 - a1 * c + a2 * c2 - a3 * c3 + a4 * c4);
+      });
+     };
+
+     switch (type)
+     {
+     case DigitalFilter::Triangular:
+      for (int n = 0; n < length; n++)
+       window[(size_t)n] = static_cast<float>(1.0 - std::abs((n - centre) / centre));
+      break;
+     case DigitalFilter::Welch:
+      for (int n = 0; n < length; n++)
+       window[(size_t)n] = static_cast<float>(1.0 - ((n - centre) / centre) * ((n - centre) / centre));
+      break;
+     case DigitalFilter::Sine:
+      // sin (pi n / N) is the imaginary part of a rotation by pi / N
+      forEachPhasor(M_PI / N, length, [&](int n, double, double s) { window[(size_t)n] = static_cast<float>(s); });
+      break;
+     case DigitalFilter::Hann:
+      cosineSum(0.5, 0.5, 0.0, 0.0, 0.0);
+      break;
+     case DigitalFilter::Hamming:
+      cosineSum(25.0 / 46.0, 21.0 / 46.0, 0.0, 0.0, 0.0);
+      break;
+     case DigitalFilter::Blackman:
+      cosineSum(0.42, 0.5, 0.08, 0.0, 0.0);
+      break;
+     case DigitalFilter::Nuttall:
+      cosineSum(0.355768, 0.487396, 0.144232, 0.012604, 0.0);
+      break;
+     case DigitalFilter::BlackmanNuttall:
+      cosineSum(0.3635819, 0.4891775, 0.1365995, 0.0106411, 0.0);
+      break;
+     case DigitalFilter::BlackmanHarris:
+      cosineSum(0.35875, 0.48829, 0.14128, 0.01168, 0.0);
+      break;
+     case DigitalFilter::FlatTop:
+      cosineSum(0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368);
+      break;
+     case DigitalFilter::Kaiser:
+     {
+      jassert (beta >= 0.0f);
+      const auto denominator = besselI0(beta);
+
+      for (int n = 0; n < length; n++) {
+       const auto r = (n - centre) / centre;
+       window[(size_t)n] = static_cast<float>(besselI0(beta * sqrt(1.0 - r * r)) / denominator);
+      }
+      break;
+     }
+     case DigitalFilter::Rectangular:
+     default:
+      break;
+     }
+
+     return window;
+    }
+   };
+
    class FIRFilter {
   
     FIRFilterType  m_Filter_Type;
     FIRFilterWindowType m_Window_Type;
   
-    uint16_t    m_Total_Samples;
-    uint16_t    m_Shift_Samples;
+    int    m_Total_Samples;
+    int    m_Shift_Samples;
     float    m_Cutoff_freq_fc1;
     float    m_Cutoff_freq_fc2;
     float    m_Fs;
@@ -55,9 +212,10 @@ namespace DigitalFilter
   
     std::vector<float> m_vCoff;
   
-    float*    m_pfDataBuffer;
-    uint16_t    m_wBufferIndex;
-    float    m_fOut;
+    // block-wise convolution with one contiguous history per channel, folded when the design is symmetric
+    juce::dsp::FIR::Coefficients<float>::Ptr m_pCoefficients;
+    DirectConvolution::Symmetry m_Symmetry = DirectConvolution::Symmetry::none;
+    DirectConvolution m_Convolution;
   
    public:
   
@@ -72,188 +230,133 @@ namespace DigitalFilter
     /// @param fc1 Primary cutoff frequency.
     /// @param fc2 Secondary cutoff frequency (used in band-pass/band-stop filters, default = 0.0).
     /// @param as Stopband attenuation in dB (used for Kaiser window, default = 60.0).
-    FIRFilter(FIRFilterType filterType, FIRFilterWindowType window, uint16_t order , float fs, float fc1, float fc2 = 0.0f, float as = 60.0f):
-     m_Filter_Type(filterType), m_Window_Type(window), m_Fs(fs), m_Total_Samples(order), 
-     m_Cutoff_freq_fc1(fc1), m_Cutoff_freq_fc2(fc2),
-     m_vCoff(order, 0.0f)
+    FIRFilter(FIRFilterType filterType, FIRFilterWindowType window, int order , float fs, float fc1, float fc2 = 0.0f, float as = 60.0f):
+     m_Filter_Type(filterType), m_Window_Type(window), m_Total_Samples(order), 
+     m_Cutoff_freq_fc1(fc1), m_Cutoff_freq_fc2(fc2), m_Fs(fs),
+     m_vCoff((size_t)order, 0.0f)
     {
+     jassert (order > 0);
+
      m_Sampling_Time = 1.0f / fs;
      m_Shift_Samples = order / 2;
-     m_pfDataBuffer = new float[order];
-  
-     memset(m_pfDataBuffer, 0, sizeof(float) * order);
-     m_wBufferIndex = 0;
-     m_fOut = 0.0f;
   
      if(window == FIRFilterWindowType::Kaiser){
       m_Beta = kaiser_beta_As(as);
      }
   
      cofficientsCal();
-    }
-  
-    ~FIRFilter(){
-     delete[] m_pfDataBuffer;
-    }
-  
-    /// @brief Applies the FIR filter to the input signal.
-    /// @details This function processes an input sample through the FIR filter by maintaining a circular buffer, 
-    /// applying convolution with precomputed filter coefficients, and returning the filtered output.
-    /// @param in The new input sample to be filtered.
-    /// @return The filtered output sample.
-    float Filter(float in) {
-     m_pfDataBuffer[m_wBufferIndex] = in;
-     
-     m_wBufferIndex++;
-  
-     if (m_wBufferIndex == m_Total_Samples) {
-      m_wBufferIndex = 0;
-     }
-     m_fOut = 0.0f;
-  
-     uint16_t sumIndex = m_wBufferIndex;
-     for (std::size_t n = 0; n < m_Total_Samples; n++) {
-      sumIndex = (sumIndex == 0) ? m_Total_Samples - 1 : sumIndex - 1;
-      m_fOut += m_vCoff[n] * m_pfDataBuffer[sumIndex];
-     }
-     return m_fOut;
+
+     m_pCoefficients = new juce::dsp::FIR::Coefficients<float> (m_vCoff.data(), m_vCoff.size());
+     m_Symmetry = DirectConvolution::findSymmetry (m_vCoff.data(), m_Total_Samples);
     }
   
     const std::vector<float>& GetImpulseResponse(){
      return m_vCoff;
     }
-  
-    void process (juce::dsp::ProcessContextReplacing<float>& context)
+
+    /// @brief The designed coefficients, for use with the other convolution engines.
+    juce::dsp::FIR::Coefficients<float>::Ptr GetCoefficients() const {
+     return m_pCoefficients;
+    }
+
+    /// @brief Allocates the history of every channel. Call before process(), off the audio thread.
+    void prepare (const juce::dsp::ProcessSpec& spec)
     {
-     auto in = context.getInputBlock();
-     auto out = context.getOutputBlock();
-  
-        jassert (in.getNumChannels () == 1);
-        jassert (out.getNumChannels () == 1);
+     m_Convolution.prepare (spec, m_Total_Samples);
+     m_Convolution.setCoefficients (m_pCoefficients, m_Symmetry);
+    }
 
-     for (int i = 0; i < in.getNumSamples(); i++)
-      out.setSample(0, i, Filter(in.getSample(0, i)));
-    
+    void reset ()
+    {
+     m_Convolution.reset ();
+    }
+
+    /// @brief Filters every channel of the block. Does not allocate, safe on the audio thread.
+    void process (const juce::dsp::ProcessContextReplacing<float>& context)
+    {
+     m_Convolution.process (context);
     }
 
 
    private:
     void cofficientsCal() {
-     
-     for (int n = 0; n < m_Total_Samples; n++) {
-      if (n != m_Shift_Samples) {
-       switch (m_Filter_Type)
-       {
-       case DigitalFilter::LowPass:
-        m_vCoff[n] = static_cast<float>(sin(2.0 * M_PI * m_Cutoff_freq_fc1 * m_Sampling_Time * (n - m_Shift_Samples)) / (M_PI * m_Sampling_Time * (n - m_Shift_Samples)));
-        break;
-       case DigitalFilter::HighPass:
-        m_vCoff[n] = static_cast<float>(sin(M_PI * (n - m_Shift_Samples)) - sin(2.0 * M_PI * m_Cutoff_freq_fc1 * m_Sampling_Time * (n - m_Shift_Samples))) / (M_PI * m_Sampling_Time * (n - m_Shift_Samples));
-        break;
-       case DigitalFilter::BandPass:
-        m_vCoff[n] = static_cast<float>(sin(2.0 * M_PI * m_Cutoff_freq_fc2 * m_Sampling_Time * (n - m_Shift_Samples)) - sin(2.0 * M_PI * m_Cutoff_freq_fc1 * m_Sampling_Time * (n - m_Shift_Samples))) / (M_PI * m_Sampling_Time * (n - m_Shift_Samples));
-        break;
-       case DigitalFilter::BandStop:
-        m_vCoff[n] = static_cast<float>(sin(2.0 * M_PI * m_Cutoff_freq_fc1 * m_Sampling_Time * (n - m_Shift_Samples)) - sin(2.0 * M_PI * m_Cutoff_freq_fc2 * m_Sampling_Time * (n - m_Shift_Samples)) + sin(M_PI * (n - m_Shift_Samples))) / (M_PI * m_Sampling_Time * (n - m_Shift_Samples));
-        break;
-       default:
-        break;
+     const auto f1 = (double)m_Cutoff_freq_fc1 * m_Sampling_Time;
+     const auto f2 = (double)m_Cutoff_freq_fc2 * m_Sampling_Time;
+
+     // the ideal responses are sums of sin (2 pi f d) / (pi d), with d = n - shift; the
+     // sin (pi d) terms of the high-pass and band-stop are zero at whole d and are left out
+     std::vector<double> ideal((size_t)m_Total_Samples, 0.0);
+     double centre = 0.0;
+
+     switch (m_Filter_Type)
+     {
+     case DigitalFilter::LowPass:
+      addSinc(ideal, f1, 1.0);
+      centre = 2.0 * f1;
+      break;
+     case DigitalFilter::HighPass:
+      addSinc(ideal, f1, -1.0);
+      centre = 1.0 - 2.0 * f1;
+      break;
+     case DigitalFilter::BandPass:
+      addSinc(ideal, f2, 1.0);
+      addSinc(ideal, f1, -1.0);
+      centre = 2.0 * (f2 - f1);
+      break;
+     case DigitalFilter::BandStop:
+      addSinc(ideal, f1, 1.0);
+      addSinc(ideal, f2, -1.0);
+      centre = 1.0 + 2.0 * f1 - 2.0 * f2;
+      break;
+     default:
+      break;
+     }
+
+     ideal[(size_t)m_Shift_Samples] = centre;
+
+     for (int n = 0; n < m_Total_Samples; n++)
+      m_vCoff[(size_t)n] = static_cast<float>(ideal[(size_t)n]);
+
+     const auto window = WindowTables::get(m_Window_Type, m_Total_Samples, m_Window_Type == Kaiser ? m_Beta : 0.0f);
+     juce::FloatVectorOperations::multiply(m_vCoff.data(), window->data(), m_Total_Samples);
+    }
+
+    /// @brief Adds gain * sin (2 pi f d) / (pi d) for every tap but the centre one.
+    /// @details The sines come from a rotation recurrence instead of a call per tap. Eight taps
+    /// are rotated at once so the loop vectorises, and the phasors are recomputed exactly every
+    /// few thousand taps so that the rounding errors of the recurrence cannot build up.
+    void addSinc(std::vector<double>& ideal, double f, double gain) const {
+     constexpr int numLanes = 8;
+     constexpr int resyncInterval = 4096;
+
+     const auto w = 2.0 * M_PI * f;
+     const auto stepCos = cos(numLanes * w);
+     const auto stepSin = sin(numLanes * w);
+
+     double s[numLanes], c[numLanes];
+
+     for (int start = 0; start < m_Total_Samples; start += numLanes) {
+      if (start % resyncInterval == 0) {
+       for (int lane = 0; lane < numLanes; lane++) {
+        const auto d = (double)(start + lane - m_Shift_Samples);
+        s[lane] = sin(w * d);
+        c[lane] = cos(w * d);
        }
       }
-      else {
-       switch (m_Filter_Type)
-       {
-       case DigitalFilter::LowPass:
-        m_vCoff[n] = 2.0f * m_Cutoff_freq_fc1;
-        break;
-       case DigitalFilter::HighPass:
-        m_vCoff[n] = static_cast<float>(1.0 / m_Sampling_Time - 2.0 * m_Cutoff_freq_fc1);
-        break;
-       case DigitalFilter::BandPass:
-        m_vCoff[n] = 2.0 * (m_Cutoff_freq_fc2 -  m_Cutoff_freq_fc1);
-        break;
-       case DigitalFilter::BandStop:
-        m_vCoff[n] = 2.0 * m_Cutoff_freq_fc1 - 2.0 * m_Cutoff_freq_fc2 + static_cast<float>(1.0 / m_Sampling_Time);
-        break;
-       default:
-        break;
-       }
+
+      const auto numThisTime = std::min(numLanes, m_Total_Samples - start);
+
+      for (int lane = 0; lane < numThisTime; lane++) {
+       const auto d = (double)(start + lane - m_Shift_Samples);
+       ideal[(size_t)(start + lane)] += d != 0.0 ? gain * s[lane] / (M_PI * d) : 0.0;
       }
-     }
-  
-     for (int n = 0; n < m_Total_Samples; n++) {
-      switch (m_Window_Type)
-      {
-      case DigitalFilter::Rectangular:
-       //m_vWindow[n] = 1.0f;
-       m_vCoff[n] *= (m_Sampling_Time * 1.0f);
-       break;
-      case DigitalFilter::Triangular:
-       //m_vWindow[n] = 1.0 - abs((n - 0.5 * m_Total_Samples) / (0.5 * m_Total_Samples));
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (1.0f - abs((n - 0.5f * m_Total_Samples) / (0.5f * m_Total_Samples)))) ;
-       break;
-      case DigitalFilter::Welch:
-       //m_vWindow[n] = 1.0 - pow((n - 0.5 * m_Total_Samples) / (0.5 * m_Total_Samples), 2.0);
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (1.0f - pow((n - 0.5f * m_Total_Samples) / (0.5f * m_Total_Samples), 2.0f)));
-       break;
-      case DigitalFilter::Sine:
-       //m_vWindow[n] = sin(M_PI * n / ((float)m_Total_Samples));
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * sin(M_PI * n / ((float)m_Total_Samples)));
-       break;
-      case DigitalFilter::Hann:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * 0.5f * (1.0f - cos(2.0 * M_PI * n / ((double)m_Total_Samples))));
-       break;
-      case DigitalFilter::Hamming:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * ((25.0f / 46.0f) - (21.0f / 46.0f) * cos(2.0f * M_PI * n / ((double)m_Total_Samples))));
-       break;
-      case DigitalFilter::Blackman:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (0.42f - 0.5f * cos(2.0f * M_PI * n / ((double)m_Total_Samples)) + 0.08f * cos(4.0f * M_PI * n / ((double)m_Total_Samples))));
-       break;
-      case DigitalFilter::Nuttall:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (0.355768f - 0.487396f * cos(2.0 * M_PI * n / ((float)m_Total_Samples)) + 0.144232f * cos(4.0f * M_PI * n / ((double)m_Total_Samples)) - 0.012604f * cos(6.0f * M_PI * n / ((double)m_Total_Samples))));
-       break;
-      case DigitalFilter::BlackmanNuttall:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (0.3635819f - 0.4891775 * cos(2.0 * M_PI * n / ((float)m_Total_Samples)) + 0.1365995f * cos(4.0f * M_PI * n / ((float)m_Total_Samples)) - 0.0106411f * cos(6.0f * M_PI * n / ((float)m_Total_Samples))));
-       break;
-      case DigitalFilter::BlackmanHarris:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (0.35875f - 0.48829f * cos(2.0f * M_PI * n / ((float)m_Total_Samples)) + 0.14128f * cos(4.0f * M_PI * n / ((float)m_Total_Samples)) - 0.01168f * cos(6.0f * M_PI * n / ((float)m_Total_Samples))));
-       break;
-      case DigitalFilter::FlatTop:
-       m_vCoff[n] *= static_cast<float>(m_Sampling_Time * (0.21557895f - 0.41663158f * cos(2.0f * M_PI * n / ((float)m_Total_Samples)) + 0.277263158f * cos(4.0f * M_PI * n / ((float)m_Total_Samples)) - 0.083578947f * cos(6.0f * M_PI * n / ((float)m_Total_Samples)) + 0.006947368f * cos(8.0 * M_PI * n / ((float)m_Total_Samples))));
-       break;
-      case DigitalFilter::Kaiser:
-       m_vCoff[n]  *= m_Sampling_Time * kaiser(n, m_Total_Samples, m_Beta);
-       break;
-      default:
-       m_vCoff[n] *= m_Sampling_Time * 1.0f;
-       break;
+
+      for (int lane = 0; lane < numLanes; lane++) {
+       const auto nextSin = s[lane] * stepCos + c[lane] * stepSin;
+       c[lane] = c[lane] * stepCos - s[lane] * stepSin;
+       s[lane] = nextSin;
       }
      }
-     
-    }
-  
-    // Kaiser window 
-    //  _n      :   sample index
-    //  _N      :   window length (samples)
-    //  _beta   :   window taper parameter
-    float kaiser(uint16_t int_n, uint16_t iN, float beta)
-    {
-     // validate input
-     
-     if (int_n > iN) {
-     //fprintf(stderr,"error: kaiser(), sample index must not exceed window length\n");
-     // exit(1);
-     } else if (beta < 0) {
-       printf(stderr,"error: kaiser(), beta must be greater than or equal to zero\n");
-       exit(1);
-     }
-
-     float t = (float)int_n - (float)(iN - 1) / 2;
-     float r = 2.0f*t / (float)(iN);
-     // float r = 2.0f*(float)_i/(float)_N;
-     float a = besseli0f(beta*sqrtf(1 - r*r));
-     float b = besseli0f(beta);
-     return (a / b);
     }
   
     float kaiser_beta_As(float A) {
@@ -272,40 +375,7 @@ namespace DigitalFilter
      }
      return beta2;
     }
-     
-    float lngammaf(float z)
-    {
-     float g;
-     if (z < 0) {
-      fprintf(stderr,"error: lngammaf(), undefined for z <= 0\n");
-      exit(1);
-     }
-     else if (z < 10.0f) {
-      return lngammaf(z + 1.0f) - logf(z);
-     }
-     else {
-      // high value approximation
-      g = 0.5*(logf(2 * M_PI) - log(z));
-      g += z*(logf(z + (1 / (12.0f*z - 0.1f / z))) - 1);
-     }
-  
-     return g;
-    }
-  
-    float besseli0f(float z) {
-     // use better low-signal approximation
-     if (z == 0.0f) {
-      return 1.0f;
-     }
-     unsigned int k;
-     float t, y = 0.0f;
-     for (k = 0; k < NUM_BESSELI0_ITERATIONS; k++) {
-  
-      t = k * logf(0.5f*z) - lngammaf((float)k + 1.0f);
-      y += expf(2 * t);
-     }
-     return y;
-    }
   
+    JUCE_DECLARE_NON_COPYABLE (FIRFilter)
   };
 }
\ No newline at end of file
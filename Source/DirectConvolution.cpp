@@ -0,0 +1,383 @@
+#include "DirectConvolution.h"
+
+namespace
+{
+    /** Sums in double. The product of two floats is exact in double, so only the additions round. */
+    struct DoubleSums
+    {
+        using Term = double;
+
+        void add (int i, Term h, Term value) noexcept { sums[i] += h * value; }
+
+        double* sums;
+    };
+
+    /** Float sums that carry the rounding error of each addition into the next one.
+        Only correct without -ffast-math, which would fold the compensation away.
+    */
+    struct CompensatedSums
+    {
+        using Term = float;
+
+        void add (int i, Term h, Term value) noexcept
+        {
+            const auto term = h * value - compensation[i];
+            const auto sum = sums[i] + term;
+            compensation[i] = (sum - sums[i]) - term;
+            sums[i] = sum;
+        }
+
+        float* sums;
+        float* compensation;
+    };
+}
+
+DirectConvolution::Symmetry DirectConvolution::findSymmetry (const SampleType* coefficients, int numTaps)
+{
+    if (numTaps < 2)
+        return Symmetry::none;
+
+    SampleType peak = 0;
+
+    for (int i = 0; i < numTaps; ++i)
+        peak = jmax (peak, std::abs (coefficients[i]));
+
+    // designs evaluate mirrored taps with separate cos() calls, so allow for rounding
+    const auto tolerance = peak * (SampleType)1.0e-6;
+    auto isSymmetric = true;
+    auto isAntisymmetric = true;
+
+    for (int i = 0; i < (numTaps + 1) / 2; ++i)
+    {
+        const auto a = coefficients[i];
+        const auto b = coefficients[numTaps - 1 - i];
+
+        isSymmetric = isSymmetric && std::abs (a - b) <= tolerance;
+        isAntisymmetric = isAntisymmetric && std::abs (a + b) <= tolerance;
+    }
+
+    if (isSymmetric && numTaps % 2 == 1 && numTaps >= 7)
+    {
+        const auto centre = numTaps / 2;
+        auto isHalfBand = true;
+
+        for (int i = centre - 2; i >= 0 && isHalfBand; i -= 2)
+            isHalfBand = std::abs (coefficients[i]) <= tolerance;
+
+        if (isHalfBand)
+            return Symmetry::halfBand;
+    }
+
+    if (isSymmetric)
+        return Symmetry::symmetric;
+
+    return isAntisymmetric ? Symmetry::antisymmetric : Symmetry::none;
+}
+
+void DirectConvolution::prepare (const Spec& spec, int maxNumTaps)
+{
+    maximumBlockSize = (int)spec.maximumBlockSize;
+    historySize = jmax (0, maxNumTaps - 1);
+
+    // leave enough room that compacting the history is needed at most once per historySize samples
+    capacity = historySize + jmax (4 * maximumBlockSize, historySize);
+
+    channels.resize (spec.numChannels);
+
+    for (auto& channel : channels)
+        channel.history.allocate ((size_t)capacity, true);
+
+    previousTaps.allocate ((size_t)(historySize + 1), true);
+    morphedTaps.allocate ((size_t)(historySize + 1), true);
+    crossfadeBuffer.allocate ((size_t)maximumBlockSize, true);
+    doubleSums.allocate ((size_t)maximumBlockSize, true);
+    compensation.allocate ((size_t)maximumBlockSize, true);
+
+    reset ();
+}
+
+void DirectConvolution::setCoefficients (Coefficients::Ptr newCoefficients, Symmetry newSymmetry)
+{
+    // taps beyond maxNumTaps are ignored in process(), which also breaks the symmetry
+    if (newCoefficients != nullptr && (int)newCoefficients->getFilterSize () > historySize + 1)
+        newSymmetry = Symmetry::none;
+
+    const auto numTaps = coefficients != nullptr ? jmin ((int)coefficients->getFilterSize (), historySize + 1) : 0;
+
+    if (crossfadeLength > 0 && numTaps > 0 && newCoefficients != nullptr)
+    {
+        if (isMorphing ())
+        {
+            // a morph is interrupted: start the next one from the mix that is audible right now
+            const auto amount = (SampleType)crossfadePosition / (SampleType)crossfadeLength;
+            const auto numMixedTaps = jmax (numPreviousTaps, numTaps);
+
+            FloatVectorOperations::clear (previousTaps + numPreviousTaps, numMixedTaps - numPreviousTaps);
+            FloatVectorOperations::multiply (previousTaps.get (), 1 - amount, numPreviousTaps);
+            FloatVectorOperations::addWithMultiply (previousTaps.get (), coefficients->getRawCoefficients (), amount, numTaps);
+
+            if (numPreviousTaps != numTaps || previousSymmetry != symmetry)
+                previousSymmetry = Symmetry::none;
+
+            numPreviousTaps = numMixedTaps;
+        }
+        else
+        {
+            FloatVectorOperations::copy (previousTaps.get (), coefficients->getRawCoefficients (), numTaps);
+            numPreviousTaps = numTaps;
+            previousSymmetry = symmetry;
+        }
+
+        crossfadePosition = 0;
+    }
+    else
+    {
+        crossfadePosition = crossfadeLength;
+    }
+
+    std::swap (coefficients, newCoefficients);
+    symmetry = newSymmetry;
+}
+
+void DirectConvolution::setCrossfadeLength (int numSamples)
+{
+    crossfadeLength = jmax (0, numSamples);
+    crossfadePosition = jmin (crossfadePosition, crossfadeLength);
+}
+
+void DirectConvolution::reset ()
+{
+    for (auto& channel : channels)
+    {
+        channel.history.clear ((size_t)capacity);
+        channel.writePosition = historySize;
+    }
+
+    crossfadePosition = crossfadeLength;
+}
+
+void DirectConvolution::process (const Context& context)
+{
+    auto& inputBlock = context.getInputBlock ();
+    auto& outputBlock = context.getOutputBlock ();
+
+    const auto numChannels = jmin (outputBlock.getNumChannels (), channels.size ());
+    const auto numSamples = (int)inputBlock.getNumSamples ();
+
+    const auto numTaps = coefficients != nullptr ? jmin ((int)coefficients->getFilterSize (), historySize + 1) : 0;
+    const auto* taps = coefficients != nullptr ? coefficients->getRawCoefficients () : nullptr;
+
+    for (int start = 0; start < numSamples;)
+    {
+        auto numThisTime = jmin (maximumBlockSize, numSamples - start);
+
+        const auto* kernelTaps = taps;
+        auto kernelSymmetry = symmetry;
+        const auto morphing = isMorphing () && numTaps > 0;
+        const auto interpolating = morphing && numPreviousTaps == numTaps;
+
+        if (morphing)
+            numThisTime = jmin (numThisTime, crossfadeLength - crossfadePosition);
+
+        if (interpolating)
+        {
+            // h = (1 - a) * previous + a * next, with a taken in the middle of the step
+            numThisTime = jmin (numThisTime, morphStepSize);
+            const auto amount = ((SampleType)crossfadePosition + (SampleType)numThisTime * (SampleType)0.5) / (SampleType)crossfadeLength;
+
+            FloatVectorOperations::multiply (morphedTaps.get (), previousTaps.get (), 1 - amount, numTaps);
+            FloatVectorOperations::addWithMultiply (morphedTaps.get (), taps, amount, numTaps);
+
+            kernelTaps = morphedTaps;
+            kernelSymmetry = previousSymmetry == symmetry ? symmetry : Symmetry::none;
+        }
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channel = channels[ch];
+
+            if (channel.writePosition + numThisTime > capacity)
+            {
+                // the ranges overlap once historySize exceeds three blocks; std::copy allows that when moving down, memcpy does not
+                const auto* source = channel.history + channel.writePosition - historySize;
+                std::copy (source, source + historySize, channel.history.get ());
+                channel.writePosition = historySize;
+            }
+
+            auto* x = channel.history + channel.writePosition;
+            auto* y = outputBlock.getChannelPointer (ch) + start;
+
+            FloatVectorOperations::copy (x, inputBlock.getChannelPointer (ch) + start, numThisTime);
+            FloatVectorOperations::clear (y, numThisTime);
+
+            convolve (y, x, kernelTaps, numTaps, kernelSymmetry, numThisTime);
+
+            if (morphing && ! interpolating)
+            {
+                // different lengths: run the previous kernel as well and fade between the outputs
+                auto* previous = crossfadeBuffer.get ();
+                FloatVectorOperations::clear (previous, numThisTime);
+                convolve (previous, x, previousTaps, numPreviousTaps, previousSymmetry, numThisTime);
+
+                for (int i = 0; i < numThisTime; ++i)
+                {
+                    const auto amount = (SampleType)(crossfadePosition + i + 1) / (SampleType)crossfadeLength;
+                    y[i] = previous[i] + amount * (y[i] - previous[i]);
+                }
+            }
+
+            channel.writePosition += numThisTime;
+        }
+
+        if (morphing)
+            crossfadePosition += numThisTime;
+
+        start += numThisTime;
+    }
+}
+
+void DirectConvolution::convolve (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples)
+{
+    switch (accumulation)
+    {
+        case Accumulation::single:
+            convolveSingle (y, x, taps, numTaps, symmetry, numSamples);
+            break;
+
+        case Accumulation::doublePrecision:
+        {
+            DoubleSums sums { doubleSums.get () };
+            std::fill_n (sums.sums, numSamples, 0.0);
+
+            accumulate (sums, x, taps, numTaps, symmetry, numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+                y[i] += (SampleType)sums.sums[i];
+
+            break;
+        }
+
+        case Accumulation::compensated:
+        {
+            // y is the running sum; it is cleared before every kernel, so no rounding error is lost
+            CompensatedSums sums { y, compensation.get () };
+            FloatVectorOperations::clear (sums.compensation, numSamples);
+
+            accumulate (sums, x, taps, numTaps, symmetry, numSamples);
+            break;
+        }
+    }
+}
+
+void DirectConvolution::convolveSingle (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples)
+{
+    switch (symmetry)
+    {
+        case Symmetry::none:
+            // y[n] = sum h[k] * x[n - k], one vectorised pass over the block per tap
+            for (int k = 0; k < numTaps; ++k)
+                FloatVectorOperations::addWithMultiply (y, x - k, taps[k], numSamples);
+            break;
+
+        case Symmetry::symmetric:
+            processFolded<true> (y, x, taps, numTaps, numSamples);
+            break;
+
+        case Symmetry::antisymmetric:
+            processFolded<false> (y, x, taps, numTaps, numSamples);
+            break;
+
+        case Symmetry::halfBand:
+            processHalfBand (y, x, taps, numTaps, numSamples);
+            break;
+    }
+}
+
+template <bool isSymmetric>
+void DirectConvolution::processFolded (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, int numSamples)
+{
+    // y[n] = sum h[k] * (x[n - k] +- x[n - (N - 1 - k)]) over the first half of the taps
+    for (int k = 0; k < numTaps / 2; ++k)
+    {
+        const auto* newer = x - k;
+        const auto* older = x - (numTaps - 1 - k);
+        const auto h = taps[k];
+
+        for (int i = 0; i < numSamples; ++i)
+            y[i] += h * (isSymmetric ? newer[i] + older[i] : newer[i] - older[i]);
+    }
+
+    // the centre tap of an odd length set has no partner, and is zero when antisymmetric
+    if (isSymmetric && numTaps % 2 == 1)
+        FloatVectorOperations::addWithMultiply (y, x - numTaps / 2, taps[numTaps / 2], numSamples);
+}
+
+void DirectConvolution::processHalfBand (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, int numSamples)
+{
+    const auto centre = numTaps / 2;
+
+    // only taps an odd distance away from the centre are non-zero, and they come in mirrored pairs
+    for (int distance = 1; distance <= centre; distance += 2)
+    {
+        const auto* newer = x - (centre - distance);
+        const auto* older = x - (centre + distance);
+        const auto h = taps[centre - distance];
+
+        for (int i = 0; i < numSamples; ++i)
+            y[i] += h * (newer[i] + older[i]);
+    }
+
+    FloatVectorOperations::addWithMultiply (y, x - centre, taps[centre], numSamples);
+}
+
+template <typename Sums>
+void DirectConvolution::accumulate (Sums& sums, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples)
+{
+    using Term = typename Sums::Term;
+
+    // the same folding as the float kernels, with the pairs added in the precision of the sums
+    const auto addPair = [&sums, numSamples] (const SampleType* newer, const SampleType* older, Term h, Term sign)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            sums.add (i, h, (Term)newer[i] + sign * (Term)older[i]);
+    };
+
+    const auto addTap = [&sums, numSamples] (const SampleType* delayed, Term h)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            sums.add (i, h, (Term)delayed[i]);
+    };
+
+    switch (symmetry)
+    {
+        case Symmetry::none:
+            for (int k = 0; k < numTaps; ++k)
+                addTap (x - k, (Term)taps[k]);
+            break;
+
+        case Symmetry::symmetric:
+        case Symmetry::antisymmetric:
+        {
+            const auto sign = symmetry == Symmetry::symmetric ? (Term)1 : (Term)-1;
+
+            for (int k = 0; k < numTaps / 2; ++k)
+                addPair (x - k, x - (numTaps - 1 - k), (Term)taps[k], sign);
+
+            if (symmetry == Symmetry::symmetric && numTaps % 2 == 1)
+                addTap (x - numTaps / 2, (Term)taps[numTaps / 2]);
+
+            break;
+        }
+
+        case Symmetry::halfBand:
+        {
+            const auto centre = numTaps / 2;
+
+            for (int distance = 1; distance <= centre; distance += 2)
+                addPair (x - (centre - distance), x - (centre + distance), (Term)taps[centre - distance], (Term)1);
+
+            addTap (x - centre, (Term)taps[centre]);
+            break;
+        }
+    }
+}
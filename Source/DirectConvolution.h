@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Block-wise direct-form FIR convolution.
+
+    Instead of running the whole tap loop once per output sample, every tap is applied to
+    the entire block at once with FloatVectorOperations::addWithMultiply, which runs on
+    SSE / NEON. The input history lives in one linear buffer per channel that is only
+    compacted once it is full, so there is no circular indexing in the inner loop and
+    changing the number of taps never requires clearing the history.
+
+    Linear-phase coefficient sets (types I to IV) are folded: the two delay-line samples
+    that share a coefficient are added (or subtracted for antisymmetric sets) first, so
+    only half the coefficients are multiplied. Half-band sets are detected as well, and
+    only their non-zero taps and the centre tap are convolved.
+
+    With a crossfade length set, a coefficient swap morphs instead of switching: the
+    history is kept and for crossfadeLength samples the output moves from the previous
+    kernel to the new one. Sets with the same number of taps are interpolated directly,
+    one short step at a time; otherwise both kernels run and their outputs are crossfaded.
+
+    Samples and taps are always stored as floats, but the sums can be kept more precisely
+    (see Accumulation): with thousands of taps, float sums leave rounding noise that can be
+    heard in a deep stopband. The precise kernels run the same folding as the float ones,
+    as plain loops the compiler vectorises.
+*/
+class DirectConvolution
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+    using Coefficients = dsp::FIR::Coefficients<SampleType>;
+
+    enum class Symmetry
+    {
+        none,
+        symmetric,      // h[k] == h[N - 1 - k], types I and II
+        antisymmetric,  // h[k] == -h[N - 1 - k], types III and IV
+        halfBand        // symmetric, odd length, and every second tap away from the centre is zero
+    };
+
+    /** How the products of each output sample are summed. */
+    enum class Accumulation
+    {
+        single,             // float sums, the fastest
+        doublePrecision,    // exact products of the floats, summed in double and rounded once
+        compensated         // float sums, each carrying the rounding error of its last addition (Kahan)
+    };
+
+    /** Checks whether the coefficients are (anti)symmetric or half-band within float rounding. */
+    static Symmetry findSymmetry (const SampleType* coefficients, int numTaps);
+
+    void prepare (const Spec& spec, int maxNumTaps);
+
+    /** Swaps in new coefficients. Does not allocate, call from the audio thread.
+        Pass the result of findSymmetry() to get the folded kernel. When morphing, the
+        kernel that is currently audible is copied as the starting point of the crossfade.
+    */
+    void setCoefficients (Coefficients::Ptr newCoefficients, Symmetry symmetry = Symmetry::none);
+
+    /** Number of samples a coefficient swap is spread over, 0 switches immediately. */
+    void setCrossfadeLength (int numSamples);
+    bool isMorphing () const { return crossfadePosition < crossfadeLength; }
+
+    /** Does not allocate, call from the audio thread. Takes effect with the next block. */
+    void setAccumulation (Accumulation newAccumulation) { accumulation = newAccumulation; }
+    Accumulation getAccumulation () const { return accumulation; }
+
+    void reset ();
+    void process (const Context& context);
+
+private:
+    struct Channel
+    {
+        HeapBlock<SampleType> history;
+        int writePosition = 0;
+    };
+
+    /** Adds the convolution of x with taps to y, picking the kernel for the symmetry and accumulation. */
+    void convolve (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples);
+
+    static void convolveSingle (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples);
+
+    /** Every kernel in one, with the products added up by Sums. */
+    template <typename Sums>
+    static void accumulate (Sums& sums, const SampleType* x, const SampleType* taps, int numTaps, Symmetry symmetry, int numSamples);
+
+    template <bool isSymmetric>
+    static void processFolded (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, int numSamples);
+
+    static void processHalfBand (SampleType* y, const SampleType* x, const SampleType* taps, int numTaps, int numSamples);
+
+    /** Coefficients are interpolated in steps of this many samples. */
+    static constexpr int morphStepSize = 32;
+
+    std::vector<Channel> channels;
+    Coefficients::Ptr coefficients;
+    Symmetry symmetry = Symmetry::none;
+
+    HeapBlock<SampleType> previousTaps, morphedTaps, crossfadeBuffer;
+
+    Accumulation accumulation = Accumulation::single;
+    HeapBlock<double> doubleSums;
+    HeapBlock<SampleType> compensation;
+    int numPreviousTaps = 0;
+    Symmetry previousSymmetry = Symmetry::none;
+    int crossfadeLength = 0;
+    int crossfadePosition = 0;
+
+    int historySize = 0;
+    int capacity = 0;
+    int maximumBlockSize = 0;
+};
@@ -11,6 +11,14 @@ namespace IDs
     static inline String AmplitudeId{ "Amplitude" };
     static inline String SplineId{ "Spline" };
     static inline String LatencyOffsetId{ "LatencyOffset" };
+    static inline String ModeId{ "Mode" };
+    static inline String CrossfadeTimeId{ "CrossfadeTime" };
+    static inline String NumBandsId{ "NumBands" };
+    static inline String BandGainId{ "BandGain" };
+    static inline String ResamplingId{ "Resampling" };
+    static inline String PhaseId{ "Phase" };
+    static inline String AccumulationId{ "Accumulation" };
+    static inline String AllowLatencyId{ "AllowLatency" };
 }
 
 StringArray createFunctionChoices ()
@@ -21,7 +29,52 @@ StringArray createFunctionChoices ()
         "LowpassTransitionMethod",
         "LowpassLeastSquaresMethod",
         "LowpassHalfBandEquirippleMethod",
-        "Custom"
+        "Custom",
+        "LowpassLeastSquaresLevinsonMethod",
+        "LowpassEquirippleMethod"
+    };
+};
+
+StringArray createModeChoices ()
+{
+    return {
+        "Direct",
+        "PartitionedFFT",
+        "NonUniformFFT",
+        "SIMDDirect",
+        "Auto",
+        "InterleavedSIMD",
+        "Morph",
+        "FilterBank",
+        "ChannelKernels"
+    };
+};
+
+StringArray createResamplingChoices ()
+{
+    return {
+        "Off",
+        "Auto",
+        "Oversample2x",
+        "Oversample4x",
+        "Multirate"
+    };
+};
+
+StringArray createPhaseChoices ()
+{
+    return {
+        "Linear",
+        "Minimum"
+    };
+};
+
+StringArray createAccumulationChoices ()
+{
+    return {
+        "Single",
+        "Double",
+        "Compensated"
     };
 };
 
@@ -39,6 +92,43 @@ StringArray createWindowTypeChoices ()
     };
 };
 
+/** Maps the WindowType choices onto the windows DigitalFilter implements. */
+static DigitalFilter::FIRFilterWindowType getDigitalFilterWindow (int windowType)
+{
+    using namespace DigitalFilter;
+
+    static constexpr FIRFilterWindowType windows[] { Rectangular, Triangular, Hann, Hamming, Blackman, BlackmanHarris, FlatTop, Kaiser };
+    return windows[jlimit (0, (int)std::size (windows) - 1, windowType)];
+}
+
+/** Octave spaced crossovers starting at the lowest one, kept below the Nyquist frequency. */
+static std::vector<float> getCrossoverFrequencies (int numBands, float lowest, double sampleRate)
+{
+    std::vector<float> frequencies;
+    const auto highest = (float)(0.45 * sampleRate);
+
+    for (int i = 0; i < numBands - 1; ++i)
+        frequencies.push_back (jmin (highest, lowest * (float)(1 << i)));
+
+    return frequencies;
+}
+
+/** Cuts a design down to maxNumTaps. Linear-phase sets lose as many taps at either end, so
+    they stay symmetric; minimum-phase sets lose their tail, where their energy is lowest.
+*/
+static dsp::FIR::Coefficients<float>::Ptr limitLength (dsp::FIR::Coefficients<float>::Ptr coefficients, int maxNumTaps, bool minimumPhase)
+{
+    const auto numTaps = coefficients != nullptr ? (int)coefficients->getFilterSize () : 0;
+
+    if (numTaps <= maxNumTaps)
+        return coefficients;
+
+    const auto numKept = minimumPhase ? maxNumTaps : maxNumTaps - (numTaps - maxNumTaps) % 2;
+    const auto offset = minimumPhase ? 0 : (numTaps - numKept) / 2;
+
+    return new dsp::FIR::Coefficients<float> (coefficients->getRawCoefficients () + offset, (size_t)numKept);
+}
+
 FirFilter::FirFilter(AudioProcessor &p)
     : processor(p)
 {
@@ -53,147 +143,927 @@ FirFilter::FirFilter(AudioProcessor &p)
     parameters.set (IDs::AmplitudeId, new AudioParameterFloat({IDs::AmplitudeId, 1}, IDs::AmplitudeId, -100.f, 0.f, -100.f));
     parameters.set (IDs::SplineId, new AudioParameterFloat({IDs::SplineId, 1}, IDs::SplineId, 1.f, 4.f, 1.f));
     parameters.set (IDs::LatencyOffsetId, new AudioParameterInt({IDs::LatencyOffsetId, 1}, IDs::LatencyOffsetId, -1, 1, 0));
+    parameters.set (IDs::ModeId, new AudioParameterChoice({IDs::ModeId, 1}, IDs::ModeId, createModeChoices(), createModeChoices().indexOf("Direct")));
+    parameters.set (IDs::CrossfadeTimeId, new AudioParameterFloat({IDs::CrossfadeTimeId, 1}, IDs::CrossfadeTimeId, 0.f, 500.f, 50.f));
+    parameters.set (IDs::ResamplingId, new AudioParameterChoice({IDs::ResamplingId, 1}, IDs::ResamplingId, createResamplingChoices(), createResamplingChoices().indexOf("Off")));
+    parameters.set (IDs::PhaseId, new AudioParameterChoice({IDs::PhaseId, 1}, IDs::PhaseId, createPhaseChoices(), createPhaseChoices().indexOf("Linear")));
+    parameters.set (IDs::NumBandsId, new AudioParameterInt({IDs::NumBandsId, 1}, IDs::NumBandsId, 2, FilterBank::maxNumBands, 4));
+
+    for (int band = 0; band < FilterBank::maxNumBands; ++band)
+    {
+        const auto id = IDs::BandGainId + String (band + 1);
+        auto* gain = new AudioParameterFloat({id, 1}, id, -24.f, 12.f, 0.f);
+        parameters.set (id, gain);
+        bandGains.add (gain);
+    }
+
+    accumulation = new AudioParameterChoice({IDs::AccumulationId, 1}, IDs::AccumulationId, createAccumulationChoices(), createAccumulationChoices().indexOf("Single"));
+    parameters.set (IDs::AccumulationId, accumulation);
+
+    // lets Auto choose the partitioned engine, which delays by a partition
+    parameters.set (IDs::AllowLatencyId, new AudioParameterBool({IDs::AllowLatencyId, 1}, IDs::AllowLatencyId, false));
 
     for (auto param : parameters)
         processor.addParameter (param);
+
+    startTimer (100);
 }
 
 FirFilter::~FirFilter()
 {
+    ++designGeneration;
+    threadPool.removeAllJobs (true, 5000);
+
+    stopTimer ();
     processor.removeListener (this);
 }
 
 void FirFilter::prepare(const Spec &spec)
 {
+    const ScopedLock sl (designLock);
+
+    // the audio thread is stopped, so the old lanes and the old layout's data can go here
+    filterSets.clear ();
+    lanes.clear ();
+    renderJobs.clear ();
+
     specs = spec;
-    filter.prepare (specs);
     delayLine.prepare (specs);
+    conversionBuffer.setSize ((int)specs.numChannels, (int)specs.maximumBlockSize);
+    loadMeter.prepare (specs.sampleRate);
+
+    // hosts switch to offline rendering before preparing for it, so the layout is decided here
+    if (processor.isNonRealtime () && specs.numChannels > 1)
+    {
+        const Spec laneSpec { specs.sampleRate, specs.maximumBlockSize, 1 };
+
+        for (uint32 ch = 0; ch < specs.numChannels; ++ch)
+        {
+            auto* lane = lanes.add (new Lane ());
+            lane->firstChannel = (int)ch;
+            prepareLane (*lane, laneSpec);
+        }
+
+        // the rendering thread takes lanes as well, so one helper less is needed
+        for (int i = 1; i < jmin (lanes.size (), threadPool.getNumThreads () + 1); ++i)
+            renderJobs.add (new RenderJob (*this));
+    }
+    else
+    {
+        prepareLane (*lanes.add (new Lane ()), specs);
+    }
+
+    planner.prepare (specs);
+    automaticStrategy.reset ();
     updateFilter ();
 }
 
+void FirFilter::prepareLane(Lane& lane, const Spec& laneSpec)
+{
+    const auto partitionSize = UniformPartitionedConvolution::getPartitionSizeForBlockSize ((int)laneSpec.maximumBlockSize);
+
+    lane.simdFilter.prepare (laneSpec, maxNumTaps);
+    lane.interleavedFilter.prepare (laneSpec, maxNumTaps);
+    lane.partitionedConvolution.prepare (laneSpec, partitionSize, maxNumTaps);
+    lane.nonUniformConvolution.prepare (laneSpec, maxNumTaps);
+    lane.filterBank.prepare (laneSpec, partitionSize, maxNumTaps);
+    lane.resampler.prepare (laneSpec);
+
+    for (int band = 0; band < FilterBank::maxNumBands; ++band)
+    {
+        lane.bandGains[band].reset (laneSpec.sampleRate, bandGainRampSeconds);
+        lane.bandGains[band].setCurrentAndTargetValue (Decibels::decibelsToGain (bandGains.getUnchecked (band)->get ()));
+    }
+}
+
 void FirFilter::process(Context context)
 {
-    Coefficients::Ptr coeff;
+    // the swap is the first thing in the block, so its time is measured from the block's start
+    LoadMeter::ScopedBlock timing (loadMeter, (int)context.getOutputBlock ().getNumSamples (), ! processor.isNonRealtime ());
+
+    if (auto* incoming = filterSets.acquire ())
+    {
+        for (auto* lane : lanes)
+            applyFilterSet (*lane, *incoming);
 
-    if (SpinLock::ScopedTryLockType sl{ swapLock }; sl.isLocked ())
-        std::swap (coeff, newCoefficients);
+        timing.swapFinished ();
+    }
+
+    auto* set = filterSets.getCurrent ();
+    auto& block = context.getOutputBlock ();
+
+    if (set == nullptr || block.getNumChannels () == 0)
+        return;
 
-    if (coeff)
+    signalTap.writeInput (block.getChannelPointer (0), (int)block.getNumSamples ());
+
+    if (lanes.size () == 1)
+    {
+        processLane (*lanes.getUnchecked (0), *set, context);
+    }
+    else
     {
-        auto state = filter.state;
+        // offline: the channels are independent, so the helpers and this thread take them in any order
+        renderSet = set;
+        renderBlock = block;
+        nextLane = 0;
 
-        // auto needsReset = coeff->coefficients.size () != state->coefficients.size ();
-        *state = *coeff;
-        filter.reset ();
+        for (auto* job : renderJobs)
+            threadPool.addJob (job, false);
+
+        processPendingLanes ();
+
+        for (auto* job : renderJobs)
+            threadPool.waitForJobToFinish (job, -1);
     }
-    
-    filter.process (context);
+
+    signalTap.writeOutput (block.getChannelPointer (0));
+}
+
+void FirFilter::process (dsp::ProcessContextReplacing<double> context)
+{
+    auto& block = context.getOutputBlock ();
+    const auto numChannels = jmin (block.getNumChannels (), (size_t)conversionBuffer.getNumChannels ());
+    const auto numSamples = block.getNumSamples ();
+
+    for (size_t start = 0; start < numSamples;)
+    {
+        const auto numThisTime = jmin (numSamples - start, (size_t)conversionBuffer.getNumSamples ());
+
+        if (numThisTime == 0)
+            return;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* source = block.getChannelPointer (ch) + start;
+            auto* destination = conversionBuffer.getWritePointer ((int)ch);
+
+            for (size_t i = 0; i < numThisTime; ++i)
+                destination[i] = (SampleType)source[i];
+        }
+
+        auto converted = Block (conversionBuffer).getSubsetChannelBlock (0, numChannels).getSubBlock (0, numThisTime);
+        process (Context (converted));
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* source = conversionBuffer.getReadPointer ((int)ch);
+            auto* destination = block.getChannelPointer (ch) + start;
+
+            for (size_t i = 0; i < numThisTime; ++i)
+                destination[i] = (double)source[i];
+        }
+
+        start += numThisTime;
+    }
+}
+
+void FirFilter::processPendingLanes()
+{
+    // the pool's threads do not inherit the host's floating point flags
+    ScopedNoDenormals noDenormals;
+
+    for (int index = nextLane++; index < lanes.size (); index = nextLane++)
+    {
+        auto* lane = lanes.getUnchecked (index);
+
+        if ((size_t)lane->firstChannel < renderBlock.getNumChannels ())
+        {
+            auto channelBlock = renderBlock.getSingleChannelBlock ((size_t)lane->firstChannel);
+            processLane (*lane, *renderSet, Context (channelBlock));
+        }
+    }
+}
+
+void FirFilter::processLane(Lane& lane, const FilterSet& set, Context context)
+{
+    lane.resampler.process (context, [this, &lane, &set] (Context internal) { processAtInternalRate (lane, set, internal); });
+}
+
+void FirFilter::processAtInternalRate (Lane& lane, const FilterSet& set, Context context)
+{
+    switch (set.mode)
+    {
+        case Mode::direct:
+        case Mode::automatic:
+        {
+            auto& block = context.getOutputBlock ();
+
+            for (size_t ch = 0; ch < block.getNumChannels (); ++ch)
+            {
+                const auto filterIndex = lane.firstChannel + (int)ch;
+
+                if (filterIndex >= set.directFilters.size ())
+                    break;
+
+                auto channelBlock = block.getSingleChannelBlock (ch);
+                set.directFilters.getUnchecked (filterIndex)->process (Context (channelBlock));
+            }
+
+            break;
+        }
+        case Mode::simdDirect:
+        case Mode::morphing:
+            lane.simdFilter.setAccumulation (static_cast<DirectConvolution::Accumulation> (accumulation->getIndex ()));
+            lane.simdFilter.process (context);
+            break;
+        case Mode::interleavedSIMD:
+            lane.interleavedFilter.process (context);
+            break;
+        case Mode::partitionedFFT:
+            lane.partitionedConvolution.process (context);
+            break;
+        case Mode::nonUniformFFT:
+            lane.nonUniformConvolution.setNonRealtime (processor.isNonRealtime ());
+            lane.nonUniformConvolution.process (context);
+            break;
+        case Mode::filterBank:
+        {
+            SampleType gains[FilterBank::maxNumBands];
+            const auto numSamples = (int)context.getOutputBlock ().getNumSamples ();
+
+            for (int band = 0; band < FilterBank::maxNumBands; ++band)
+            {
+                lane.bandGains[band].setTargetValue (Decibels::decibelsToGain (bandGains.getUnchecked (band)->get ()));
+                gains[band] = lane.bandGains[band].skip (numSamples);
+            }
+
+            lane.filterBank.process (context, gains);
+            break;
+        }
+        case Mode::channelKernels:
+            lane.partitionedConvolution.process (context);
+            break;
+    }
+
     // delayLine.process (context);
 }
 
-void FirFilter::audioProcessorParameterChanged(AudioProcessor *, int, float)
+void FirFilter::applyFilterSet (Lane& lane, const FilterSet& set)
+{
+    // only reference counts change here; nothing is freed, since the release pool keeps the data alive.
+    // The engines' history is only valid for the mode and rate it was recorded at.
+    const auto stages = set.resampling != nullptr ? set.resampling->numStages : 0;
+
+    if (set.mode != lane.mode || stages != lane.resamplingStages)
+    {
+        lane.simdFilter.setCoefficients (nullptr);
+        lane.interleavedFilter.setCoefficients (nullptr);
+        lane.partitionedConvolution.setImpulseResponse (nullptr);
+        lane.partitionedConvolution.setKernels (nullptr);
+        lane.nonUniformConvolution.setImpulseResponse (nullptr);
+        lane.filterBank.setResponses (nullptr);
+
+        lane.simdFilter.reset ();
+        lane.interleavedFilter.reset ();
+        lane.partitionedConvolution.reset ();
+        lane.nonUniformConvolution.reset ();
+        lane.filterBank.reset ();
+        lane.resampler.reset ();
+
+        for (auto& gain : lane.bandGains)
+            gain.setCurrentAndTargetValue (gain.getTargetValue ());
+
+        lane.mode = set.mode;
+        lane.resamplingStages = stages;
+    }
+
+    // the stages' kernels change with the cutoff even when their number stays the same
+    lane.resampler.setCascade (set.resampling);
+
+    switch (lane.mode)
+    {
+        case Mode::simdDirect:
+        case Mode::morphing:
+            // in morphing mode the history is kept and the swap is crossfaded
+            lane.simdFilter.setCrossfadeLength (set.crossfadeSamples);
+            lane.simdFilter.setCoefficients (set.coefficients, set.symmetry);
+            break;
+        case Mode::interleavedSIMD:
+            lane.interleavedFilter.setCoefficients (set.interleavedCoefficients);
+            break;
+        case Mode::partitionedFFT:
+            lane.partitionedConvolution.setImpulseResponse (set.impulseResponse);
+            break;
+        case Mode::nonUniformFFT:
+            lane.nonUniformConvolution.setImpulseResponse (set.nonUniformImpulseResponse);
+            break;
+        case Mode::filterBank:
+            lane.filterBank.setResponses (set.bankResponses);
+            break;
+        case Mode::channelKernels:
+            lane.partitionedConvolution.setKernels (set.kernels, lane.firstChannel);
+            break;
+        case Mode::direct:
+        case Mode::automatic:
+            break;
+    }
+}
+
+void FirFilter::audioProcessorParameterChanged(AudioProcessor *, int parameterIndex, float)
 {
+    // band gains and the accumulation are read on the audio thread and need no new design
+    for (auto* gain : bandGains)
+        if (gain->getParameterIndex () == parameterIndex)
+            return;
+
+    // Auto switches to SIMD Direct for the precise sums, which takes a new set
+    if (accumulation->getParameterIndex () == parameterIndex && getDenormalisedValue<int> (IDs::ModeId, 0) != (int)Mode::automatic)
+        return;
+
     triggerAsyncUpdate ();
 }
 
+FirFilter::Mode FirFilter::resolveMode (const DesignParameters& p, const Coefficients* coefficients, DirectConvolution::Symmetry symmetry)
+{
+    if (p.mode != Mode::automatic)
+        return p.mode;
+
+    if (coefficients == nullptr)
+        return Mode::direct;
+
+    // only the SIMD direct kernels can sum in double or compensate, so asking for it settles the choice
+    if (p.accumulation != (int)DirectConvolution::Accumulation::single)
+    {
+        automaticStrategy = ConvolutionPlanner::Strategy::simdDirect;
+        return Mode::simdDirect;
+    }
+
+    // the last choice is passed back, so that small changes near a break-even point keep the engine
+    automaticStrategy = planner.choose ((int)coefficients->getFilterSize(), symmetry, p.allowLatency, automaticStrategy);
+
+    switch (*automaticStrategy)
+    {
+        case ConvolutionPlanner::Strategy::direct:          return Mode::direct;
+        case ConvolutionPlanner::Strategy::simdDirect:      return Mode::simdDirect;
+        case ConvolutionPlanner::Strategy::partitionedFFT:  return Mode::partitionedFFT;
+        case ConvolutionPlanner::Strategy::interleavedSIMD: return Mode::interleavedSIMD;
+    }
+
+    return Mode::direct;
+}
+
+FirFilter::DesignParameters FirFilter::getDesignParameters()
+{
+    DesignParameters p;
+    p.function = getDenormalisedValue<int> (IDs::FunctionId, 0);
+    p.order = getDenormalisedValue<int> (IDs::OrderId, 21);
+    p.frequency = getDenormalisedValue<float> (IDs::FrequencyId, 1000.f);
+    p.transitionWidth = getDenormalisedValue<float> (IDs::TransitionWidthId, 0.f);
+    p.amplitude = getDenormalisedValue<float> (IDs::AmplitudeId, -100.f);
+    p.spline = getDenormalisedValue<float> (IDs::SplineId, 0.f);
+    p.windowType = getDenormalisedValue<int> (IDs::WindowTypeId, 0);
+    p.stopBandWeight = getDenormalisedValue<float> (IDs::StopBandWeightId, 1.f);
+    p.mode = static_cast<Mode> (getDenormalisedValue<int> (IDs::ModeId, 0));
+    p.crossfadeTime = getDenormalisedValue<float> (IDs::CrossfadeTimeId, 50.f);
+    p.numBands = getDenormalisedValue<int> (IDs::NumBandsId, 4);
+    p.resampling = getDenormalisedValue<int> (IDs::ResamplingId, 0);
+    p.minimumPhase = getDenormalisedValue<int> (IDs::PhaseId, 0) == 1;
+    p.allowLatency = getDenormalisedValue<int> (IDs::AllowLatencyId, 0) == 1;
+    p.accumulation = accumulation->getIndex ();
+
+    if (auto iParam = dynamic_cast<AudioParameterInt*> (parameters[IDs::LatencyOffsetId]))
+        p.latencyOffset = iParam->get ();
+
+    return p;
+}
+
+double FirFilter::getStopBandEdge(const DesignParameters& p, double sampleRate)
+{
+    // where the lowpass' stop band starts, or 0 if the design function is not a lowpass
+    switch (p.function)
+    {
+        case 0:
+            return p.frequency + 4.0 * sampleRate / (p.order + 1);
+        case 1:
+        case 2:
+        case 3:
+        case 6:
+        case 7:
+            return p.frequency + 0.5 * p.transitionWidth * sampleRate;
+        default:
+            return 0.0;
+    }
+}
+
+int FirFilter::chooseResamplingStages(const DesignParameters& p, double sampleRate)
+{
+    auto maxStages = 0;
+
+    switch (p.resampling)
+    {
+        case 2:  return 1;
+        case 3:  return 2;
+        case 1:  maxStages = 2; break;
+        case 4:  maxStages = ResamplingCascade::maxNumStages; break;
+        default: return 0;
+    }
+
+    // everything the half-band stages alias lies above their pass band, so the filter can
+    // run at the lower rate if it removes all of that
+    const auto stopBandEdge = getStopBandEdge (p, sampleRate);
+
+    if (stopBandEdge <= 0.0)
+        return 0;
+
+    return -ResamplingCascade::getMaxNumDecimationStages (stopBandEdge / sampleRate, maxStages);
+}
+
 void FirFilter::updateFilter()
 {
-    const auto sr = specs.sampleRate;
-    
-    const auto nyquist = sr / 2.0;
-    const auto freq = jlimit (0.0f, (float)nyquist, getDenormalisedValue<float> (IDs::FrequencyId, 1000.f));
-    const auto order = getDenormalisedValue<int> (IDs::OrderId, 21);
-    const auto transitionWidth = getDenormalisedValue<float> (IDs::TransitionWidthId, 0.f);
-    const auto amplitude = getDenormalisedValue<float> (IDs::AmplitudeId, -100.f);
-    const auto spline = getDenormalisedValue<float> (IDs::SplineId, 0.f);
-    const auto type = static_cast<dsp::WindowingFunction<float>::WindowingMethod> (getDenormalisedValue<int> (IDs::WindowTypeId, 0));
-    const auto function = getDenormalisedValue<int> (IDs::FunctionId, 0);
-    const auto stopBandWeight = getDenormalisedValue<float> (IDs::StopBandWeightId, 1.f);
+    designFilter (getDesignParameters (), ++designGeneration);
+    latencyReporter.flush ();
+}
 
-    SpinLock::ScopedLockType lock (swapLock);
+DesignCache::Key FirFilter::getDesignKey(const DesignParameters& p, float frequency, double sampleRate)
+{
+    // only the inputs the design function actually reads, so that unrelated parameters still hit the cache
+    DesignCache::Key key;
+    key.function = p.function;
+    key.sampleRate = sampleRate;
+    key.minimumPhase = p.minimumPhase;
 
-    switch (function)
+    switch (p.function)
     {
         case 0:
-            newCoefficients = FilterDesign::designFIRLowpassWindowMethod (freq, sr, order, type);
+            key.frequency = frequency;
+            key.order = p.order;
+            key.windowType = p.windowType;
             break;
         case 1:
-            newCoefficients = FilterDesign::designFIRLowpassKaiserMethod (freq, sr, transitionWidth, amplitude);
+            key.frequency = frequency;
+            key.transitionWidth = p.transitionWidth;
+            key.amplitude = p.amplitude;
             break;
         case 2:
-            newCoefficients = FilterDesign::designFIRLowpassTransitionMethod (freq, sr, order, transitionWidth, spline);
+            key.frequency = frequency;
+            key.order = p.order;
+            key.transitionWidth = p.transitionWidth;
+            key.spline = p.spline;
             break;
         case 3:
-            newCoefficients = FilterDesign::designFIRLowpassLeastSquaresMethod (freq, sr, order, transitionWidth, stopBandWeight);
+        case 6:
+        case 7:
+            key.frequency = frequency;
+            key.order = p.order;
+            key.transitionWidth = p.transitionWidth;
+            key.stopBandWeight = p.stopBandWeight;
             break;
         case 4:
-            newCoefficients = FilterDesign::designFIRLowpassHalfBandEquirippleMethod (jlimit (0.f, 0.5f, transitionWidth), jlimit (-300.f, -10.f, amplitude));
+            key.transitionWidth = p.transitionWidth;
+            key.amplitude = p.amplitude;
+            break;
+        default:
             break;
-        case 5:
+    }
+
+    return key;
+}
+
+void FirFilter::designFilter(const DesignParameters& p, uint32 generation)
+{
+    // a newer snapshot has been taken since this design was started, so its result would never be heard
+    auto isStale = [&] { return generation != designGeneration.load (); };
+
+    // designLock is only held to read the engine layouts and to publish, so prepare() never
+    // waits for the maths. A prepare() in between makes the design stale, and it is dropped
+    // before anything built for the old layout reaches the audio thread
+    Spec spec;
+    int bankPartitionSize = 0;
+    int partitionSize = 0;
+    NonUniformPartitionedConvolution::Layout nonUniformLayout;
+
+    {
+        const ScopedLock sl (designLock);
+
+        if (isStale () || lanes.isEmpty ())
+            return;
+
+        // every lane is prepared with the same settings, so the first one answers for all of them
+        auto& engines = *lanes.getFirst ();
+
+        spec = specs;
+        bankPartitionSize = engines.filterBank.getPartitionSize ();
+        partitionSize = engines.partitionedConvolution.getPartitionSize ();
+        nonUniformLayout = engines.nonUniformConvolution.getLayout ();
+    }
+
+    // the response stays the same in Hz at the internal rate, so the order and the
+    // normalised transition width scale with it
+    const auto runsAtHostRate = p.mode == Mode::filterBank || p.mode == Mode::channelKernels;
+    const auto stages = runsAtHostRate ? 0 : chooseResamplingStages (p, spec.sampleRate);
+    const auto rateRatio = std::ldexp (1.0, stages);
+
+    auto scaled = p;
+    scaled.order = jlimit (1, maxNumTaps - 1, roundToInt (p.order * rateRatio));
+    scaled.transitionWidth = jlimit (0.0001f, 0.5f, (float)(p.transitionWidth / rateRatio));
+
+    const auto sr = spec.sampleRate * rateRatio;
+    
+    const auto nyquist = sr / 2.0;
+    const auto freq = jlimit (0.0f, (float)nyquist, p.frequency);
+    const auto order = scaled.order;
+    const auto transitionWidth = scaled.transitionWidth;
+    const auto amplitude = p.amplitude;
+    const auto spline = p.spline;
+    const auto type = static_cast<dsp::WindowingFunction<float>::WindowingMethod> (p.windowType);
+    const auto stopBandWeight = p.stopBandWeight;
+
+    if (p.mode == Mode::filterBank)
+    {
+        // the band designs only take microseconds, so they are not cached. DigitalFilter's windows
+        // are only symmetric about the sinc's centre for odd lengths, so the bank rounds up to one,
+        // which keeps every band linear phase with a delay of exactly numTaps / 2
+        const auto numTaps = jlimit (1, maxNumTaps - 1, order + 1) | 1;
+
+        auto set = std::make_unique<FilterSet> ();
+        set->mode = Mode::filterBank;
+        set->bankResponses = new FilterBankResponses (getCrossoverFrequencies (p.numBands, freq, sr), sr, numTaps,
+                                                      getDigitalFilterWindow (p.windowType), amplitude, bankPartitionSize);
+
+        const ScopedLock sl (designLock);
+
+        if (isStale ())
+            return;
+
+        releasePool.add (set->bankResponses);
+        filterSets.publish (std::move (set));
+        setActiveCoefficients (nullptr, sr);
+
+        latencyReporter.report (jmax (0, numTaps / 2 + lanes.getFirst ()->filterBank.getLatencyInSamples() + p.latencyOffset));
+        return;
+    }
+
+    if (p.mode == Mode::channelKernels)
+    {
+        // the loaded kernels replace the designed filter, and keep whatever delay they have themselves
+        Coefficients::Ptr firstKernel;
+        double firstKernelRate = spec.sampleRate;
+
+        auto set = std::make_unique<FilterSet> ();
+        set->mode = Mode::channelKernels;
+        set->kernels = updateKernelStore (spec.sampleRate, partitionSize, firstKernel, firstKernelRate);
+
+        const ScopedLock sl (designLock);
+
+        if (isStale ())
+            return;
+
+        releasePool.add (set->kernels);
+        filterSets.publish (std::move (set));
+        setActiveCoefficients (firstKernel, firstKernelRate);
+
+        latencyReporter.report (jmax (0, lanes.getFirst ()->partitionedConvolution.getLatencyInSamples() + p.latencyOffset));
+        return;
+    }
+
+    const auto key = getDesignKey (scaled, freq, sr);
+    DesignCache::Entry design;
+    bool isCached;
+
+    {
+        const ScopedLock sl (designLock);
+        isCached = designCache.lookup (key, design);
+    }
+
+    if (! isCached)
+    {
+        switch (p.function)
         {
+            case 0:
+                design.coefficients = FilterDesign::designFIRLowpassWindowMethod (freq, sr, order, type);
+                break;
+            case 1:
+                design.coefficients = FilterDesign::designFIRLowpassKaiserMethod (freq, sr, transitionWidth, amplitude);
+                break;
+            case 2:
+                design.coefficients = FilterDesign::designFIRLowpassTransitionMethod (freq, sr, order, transitionWidth, spline);
+                break;
+            case 3:
+                design.coefficients = FilterDesign::designFIRLowpassLeastSquaresMethod (freq, sr, order, transitionWidth, stopBandWeight);
+                break;
+            case 4:
+                design.coefficients = FilterDesign::designFIRLowpassHalfBandEquirippleMethod (jlimit (0.f, 0.5f, transitionWidth), jlimit (-300.f, -10.f, amplitude));
+                break;
+            case 5:
+            {
 
-            Array<float> coeff{ 0.3f, 0.2f, 0.1f, 0.2f, 0.1f, 0.2f, 0.3f };
-            newCoefficients = new Coefficients (coeff.getRawDataPointer (), coeff.size () );
-            delayLine.setDelay (coeff.size () / 2);
+                Array<float> coeff{ 0.3f, 0.2f, 0.1f, 0.2f, 0.1f, 0.2f, 0.3f };
+                design.coefficients = new Coefficients (coeff.getRawDataPointer (), coeff.size () );
 
-            break;
+                break;
+            }
+            case 6:
+                design.coefficients = FilterDesigner::designFIRLowpassLeastSquaresMethod (freq, sr, order, transitionWidth, stopBandWeight);
+                break;
+            case 7:
+                design.coefficients = FilterDesigner::designFIRLowpassEquirippleMethod (freq, sr, order, transitionWidth, stopBandWeight);
+                break;
+            default:
+                jassertfalse; // Invalid function
+                break;
         }
-        default:
-            jassertfalse; // Invalid function
-            break;
+
+        if (isStale ())
+            return;
+
+        // done on the original design rather than per set, so the cache keeps the slow part
+        if (p.minimumPhase && design.coefficients != nullptr)
+            design.coefficients = FilterDesigner::makeMinimumPhase (*design.coefficients);
+
+        // the Kaiser method picks its own order, which can exceed what the engines hold
+        design.coefficients = limitLength (design.coefficients, maxNumTaps, p.minimumPhase);
+
+        if (isStale ())
+            return;
+
+        // linear-phase and half-band sets run through the folded kernels whenever the SIMD direct path is used
+        design.symmetry = design.coefficients ? DirectConvolution::findSymmetry (design.coefficients->getRawCoefficients(), (int)design.coefficients->getFilterSize())
+                                              : DirectConvolution::Symmetry::none;
     }
 
+    const auto newCoefficients = design.coefficients;
+    const auto symmetry = design.symmetry;
 
-    auto latencySamples = (int)(newCoefficients ? newCoefficients->getFilterOrder() / 2 : 0);
-    
-    if (auto iParam = dynamic_cast<AudioParameterInt*> (parameters[IDs::LatencyOffsetId]))
-        latencySamples += iParam->get ();
+    DBG ("Symmetric: " << (int)(symmetry == DirectConvolution::Symmetry::symmetric || symmetry == DirectConvolution::Symmetry::halfBand));
+    DBG ("Anti-Symmetric: " << (int)(symmetry == DirectConvolution::Symmetry::antisymmetric));
+
+    Mode processingMode;
+
+    {
+        // prepare() measures the planner again
+        const ScopedLock sl (designLock);
+
+        if (isStale ())
+            return;
+
+        processingMode = resolveMode (p, newCoefficients.get (), symmetry);
+    }
+
+    auto set = std::make_unique<FilterSet> ();
+    set->mode = processingMode;
+
+    // the stages only have to keep the filter's pass and transition band free of aliases,
+    // with at least the stop band attenuation asked for
+    if (stages != 0)
+        set->resampling = new ResamplingCascade (stages, getStopBandEdge (p, spec.sampleRate) / spec.sampleRate,
+                                                 jlimit (-150.f, -60.f, amplitude));
+
+    set->symmetry = symmetry;
+    set->crossfadeSamples = processingMode == Mode::morphing ? roundToInt (p.crossfadeTime * 0.001 * sr) : 0;
+    set->coefficients = newCoefficients;
+
+    if (newCoefficients && (processingMode == Mode::direct || processingMode == Mode::automatic))
+    {
+        const Spec channelSpec { spec.sampleRate, spec.maximumBlockSize, 1 };
+
+        for (uint32 ch = 0; ch < spec.numChannels; ++ch)
+            set->directFilters.add (new Filter (newCoefficients))->prepare (channelSpec);
+    }
 
-    latencySamples = jmax (0, latencySamples);
+    // cached spectra are reused as long as they were transformed for the current partition size
+    if (newCoefficients && processingMode == Mode::partitionedFFT)
+    {
+        if (design.impulseResponse == nullptr || design.impulseResponse->partitionSize != partitionSize)
+            design.impulseResponse = new PartitionedImpulseResponse (newCoefficients->getRawCoefficients(),
+                                                                     jmin ((int)newCoefficients->getFilterSize(), maxNumTaps),
+                                                                     partitionSize);
+
+        set->impulseResponse = design.impulseResponse;
+    }
+
+    if (newCoefficients && processingMode == Mode::nonUniformFFT)
+    {
+        if (design.nonUniformImpulseResponse == nullptr)
+            design.nonUniformImpulseResponse = NonUniformPartitionedConvolution::createImpulseResponse (nonUniformLayout, newCoefficients->getRawCoefficients(),
+                                                                                                       jmin ((int)newCoefficients->getFilterSize(), maxNumTaps));
+
+        set->nonUniformImpulseResponse = design.nonUniformImpulseResponse;
+    }
+
+    const ScopedLock sl (designLock);
+
+    if (isStale ())
+        return;
+
+    auto& engines = *lanes.getFirst ();
+
+    // only copies the taps for every group, so it can be done while holding the lock
+    if (newCoefficients && processingMode == Mode::interleavedSIMD)
+        set->interleavedCoefficients = engines.interleavedFilter.createExpandedCoefficients (*newCoefficients);
+
+    designCache.store (key, design);
+
+    // the Custom set is delayed by its centre tap
+    if (p.function == 5 && newCoefficients)
+        delayLine.setDelay ((SampleType)(newCoefficients->getFilterSize () / 2));
+
+    // the engines may keep references after the set is retired, and the cache shares them between sets
+    releasePool.add (set->coefficients);
+    releasePool.add (set->interleavedCoefficients);
+    releasePool.add (set->impulseResponse);
+    releasePool.add (set->resampling);
+
+    if (set->nonUniformImpulseResponse != nullptr)
+        for (auto& segment : set->nonUniformImpulseResponse->segments)
+            releasePool.add (segment);
+
+    // the lanes only get a worker thread once a non-uniform set is about to reach them
+    if (set->nonUniformImpulseResponse != nullptr)
+        for (auto* lane : lanes)
+            lane->nonUniformConvolution.startWorker ();
+
+    const auto resamplingDelay = set->resampling != nullptr ? set->resampling->getDelayInSamples() : 0.0;
+
+    filterSets.publish (std::move (set));
+    setActiveCoefficients (newCoefficients, sr);
+
+    // a minimum-phase set has no constant delay to compensate, its energy is at the start.
+    // An odd order delays by half a sample, which the rate ratio can turn into many host
+    // samples, so the delay is only rounded once it is at the host rate
+    auto delay = newCoefficients && ! p.minimumPhase ? newCoefficients->getFilterOrder() * 0.5 : 0.0;
+
+    if (processingMode == Mode::partitionedFFT)
+        delay += engines.partitionedConvolution.getLatencyInSamples();
+    else if (processingMode == Mode::nonUniformFFT)
+        delay += engines.nonUniformConvolution.getLatencyInSamples();
+
+    // halves round down, as order / 2 always did at the host rate
+    const auto latencySamples = jmax (0, (int)std::ceil (delay / rateRatio + resamplingDelay - 0.5) + p.latencyOffset);
+
+    latencyReporter.report (latencySamples);
+}
+
+void FirFilter::setActiveCoefficients(Coefficients::Ptr coefficients, double sampleRate)
+{
+    const ScopedLock sl (activeCoefficientsLock);
+    activeCoefficients = coefficients;
+    activeSampleRate = sampleRate;
+    ++activeCoefficientsVersion;
+}
+
+FirFilter::Coefficients::Ptr FirFilter::getActiveCoefficients(double& sampleRate) const
+{
+    const ScopedLock sl (activeCoefficientsLock);
+    sampleRate = activeSampleRate;
+    return activeCoefficients;
+}
+
+bool FirFilter::loadImpulseResponse(const File& file, int firstChannel)
+{
+    AudioFormatManager formats;
+    formats.registerBasicFormats ();
+
+    std::unique_ptr<AudioFormatReader> reader (formats.createReaderFor (file));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return false;
+
+    // long enough for maxNumTaps even after resampling from four times the rate
+    const auto numChannels = (int)reader->numChannels;
+    const auto numSamples = (int)jmin (reader->lengthInSamples, (int64)maxNumTaps * 4);
+
+    AudioBuffer<float> buffer (numChannels, numSamples);
+    reader->read (&buffer, 0, numSamples, 0, true, true);
+
+    const ScopedLock sl (kernelLock);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto* source = kernelSources.add (new KernelSource ());
+        source->taps.assign (buffer.getReadPointer (i), buffer.getReadPointer (i) + numSamples);
+        source->sampleRate = reader->sampleRate;
+
+        const auto kernel = kernelSources.size () - 1;
+
+        if (firstChannel < 0 && numChannels == 1)
+            std::fill (channelKernels.begin (), channelKernels.end (), kernel);
+        else if (isPositiveAndBelow (jmax (0, firstChannel) + i, maxNumChannels))
+            channelKernels[(size_t)(jmax (0, firstChannel) + i)] = kernel;
+    }
+
+    // drop the kernels no channel uses any more, keeping the indices in channelKernels valid
+    for (int kernel = kernelSources.size (); --kernel >= 0;)
+    {
+        if (std::find (channelKernels.begin (), channelKernels.end (), kernel) != channelKernels.end ())
+            continue;
+
+        kernelSources.remove (kernel);
 
-    processor.setLatencySamples (latencySamples);
+        for (auto& index : channelKernels)
+            if (index > kernel)
+                --index;
+    }
 
-    auto isSymmetric = [&](){
-        if (! newCoefficients)
-            return false;
+    kernelStoreIsCurrent = false;
+    ++kernelSourcesVersion;
+    triggerAsyncUpdate ();
+    return true;
+}
 
-        auto& coeffs = newCoefficients->coefficients;
-        
-        if (coeffs.size() % 2 == 0)
-            return false; // Even length coefficients cannot be symmetric
+void FirFilter::clearImpulseResponses()
+{
+    const ScopedLock sl (kernelLock);
 
-        for (size_t i = 0; i < coeffs.size() / 2; ++i)
+    kernelSources.clear ();
+    std::fill (channelKernels.begin (), channelKernels.end (), -1);
+
+    kernelStoreIsCurrent = false;
+    ++kernelSourcesVersion;
+    triggerAsyncUpdate ();
+}
+
+KernelStore::Ptr FirFilter::updateKernelStore(double sampleRate, int partitionSize, Coefficients::Ptr& firstKernel, double& firstKernelRate)
+{
+    // the sources are copied out under kernelLock and transformed without it
+    std::vector<KernelSource> sources;
+    std::vector<int> channels;
+    KernelStore::Ptr previous;
+    uint32 version;
+    bool canReuse;
+
+    {
+        const ScopedLock sl (kernelLock);
+
+        if (auto kernel = channelKernels.front (); isPositiveAndBelow (kernel, kernelSources.size ()))
         {
-            if (coeffs[i] != coeffs[coeffs.size() - 1 - i])
-                return false;
+            const auto& source = *kernelSources.getUnchecked (kernel);
+            firstKernel = new Coefficients (source.taps.data (), source.taps.size ());
+            firstKernelRate = source.sampleRate;
         }
-        
-        return true;
-    };
 
-    auto isAntiSymmetric = [&](){
-        if (! newCoefficients)
-            return false;
+        canReuse = kernelStore != nullptr && kernelStore->partitionSize == partitionSize && kernelStoreSampleRate == sampleRate;
+
+        if (canReuse && kernelStoreIsCurrent)
+            return kernelStore;
 
-        auto& coeffs = newCoefficients->coefficients;
-        
-        if (coeffs.size() % 2 == 0)
-            return false; // Even length coefficients cannot be anti-symmetric
+        for (auto* source : kernelSources)
+            sources.push_back (*source);
+
+        channels = channelKernels;
+        previous = kernelStore;
+        version = kernelSourcesVersion;
+    }
+
+    KernelStore::Ptr store = new KernelStore ((int)sources.size (), maxNumTaps, partitionSize, maxNumChannels);
+
+    for (int kernel = 0; kernel < (int)sources.size (); ++kernel)
+    {
+        const auto& source = sources[(size_t)kernel];
 
-        for (size_t i = 0; i < coeffs.size() / 2; ++i)
+        // kernels that were transformed for the current layout only need copying
+        if (canReuse && source.storeIndex >= 0)
         {
-            if (coeffs[i] != -coeffs[coeffs.size() - 1 - i])
-                return false;
+            store->copyKernel (kernel, *previous, source.storeIndex);
         }
-        
-        return true;
-    };
-    
-    DBG ("Symmetric: " << (int)isSymmetric());
-    DBG ("Anti-Symmetric: " << (int)isAntiSymmetric());
+        else if (source.sampleRate == sampleRate)
+        {
+            store->setKernel (kernel, source.taps.data (), (int)source.taps.size ());
+        }
+        else
+        {
+            const auto ratio = source.sampleRate / sampleRate;
+            // the interpolator looks a few samples ahead, so it stops short of the end
+            std::vector<float> resampled ((size_t)jlimit (1, maxNumTaps, (int)(source.taps.size () / ratio) - 4));
+
+            // scaled so that the response keeps its gain at the new rate
+            LagrangeInterpolator ().process (ratio, source.taps.data (), resampled.data (), (int)resampled.size ());
+            FloatVectorOperations::multiply (resampled.data (), (float)ratio, (int)resampled.size ());
+
+            store->setKernel (kernel, resampled.data (), (int)resampled.size ());
+        }
+    }
+
+    for (int ch = 0; ch < maxNumChannels; ++ch)
+        store->setChannelKernel (ch, channels[(size_t)ch]);
+
+    const ScopedLock sl (kernelLock);
+
+    // a file loaded in the meantime has queued another design, which builds its own store
+    if (version == kernelSourcesVersion)
+    {
+        for (int kernel = 0; kernel < kernelSources.size (); ++kernel)
+            kernelSources.getUnchecked (kernel)->storeIndex = kernel;
+
+        kernelStore = store;
+        kernelStoreSampleRate = sampleRate;
+        kernelStoreIsCurrent = true;
+    }
+
+    return store;
 }
 
 void FirFilter::handleAsyncUpdate()
 {
-    updateFilter ();
+    const auto generation = ++designGeneration;
+
+    // queued designs are dropped, a running one gives up at its next check
+    threadPool.removeAllJobs (true, 0);
+    threadPool.addJob (new DesignJob (*this, getDesignParameters (), generation), true);
+}
+
+void FirFilter::timerCallback()
+{
+    filterSets.collectGarbage ();
+    releasePool.releaseUnused ();
 }
@@ -1,8 +1,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PartitionedConvolution.h"
+#include "NonUniformConvolution.h"
+#include "DirectConvolution.h"
+#include "InterleavedConvolution.h"
+#include "ConvolutionPlanner.h"
+#include "DesignCache.h"
+#include "FilterDesigner.h"
+#include "FilterBank.h"
+#include "PolyphaseResampler.h"
+#include "RealtimeHandover.h"
+#include "LoadMeter.h"
+#include "SignalTap.h"
 
-class FirFilter : AudioProcessorListener, private AsyncUpdater
+class FirFilter : AudioProcessorListener, private AsyncUpdater, private Timer
 {
 public:
     FirFilter (AudioProcessor& p);
@@ -16,27 +28,251 @@ public:
     using Spec = dsp::ProcessSpec;
     using FilterDesign = dsp::FilterDesign<SampleType>;
 
+    enum class Mode
+    {
+        direct,
+        partitionedFFT,
+        nonUniformFFT,
+        simdDirect,
+        automatic,
+        interleavedSIMD,
+        morphing,
+        filterBank,
+        channelKernels
+    };
+
+    /** Upper bound for the number of taps any design may produce. */
+    static constexpr int maxNumTaps = 8192;
+
+    /** Largest bus accepted: one interleaved group, enough for 7.1.4 and third order Ambisonics. */
+    static constexpr int maxNumChannels = InterleavedConvolution::maxGroupSize;
+
+    /** How long a band gain change takes to settle in the Filter Bank mode. */
+    static constexpr double bandGainRampSeconds = 0.02;
+
     void prepare (const Spec& spec);
     void process (Context context);
-    void audioProcessorParameterChanged (AudioProcessor*, int, float) override;
+
+    /** For hosts that process in double precision. The engines store floats, so the block
+        is converted a prepared block size at a time; the Accumulation parameter decides how
+        precisely the SIMD Direct and Morph modes sum their taps. The other engines have no
+        choice, so Auto picks SIMD Direct whenever it is not Single.
+    */
+    void process (dsp::ProcessContextReplacing<double> context);
+
+    void audioProcessorParameterChanged (AudioProcessor*, int parameterIndex, float) override;
     void audioProcessorChanged (AudioProcessor* processor, const ChangeDetails& details) override { /* unused */ };
 
+    /** Loads an impulse response file as per-channel kernels for the ChannelKernels mode.
+
+        Channel i of the file becomes the kernel of channel firstChannel + i; a mono file
+        with firstChannel -1 is used by every channel. Other channels keep their kernels.
+        Kernels are resampled to the current sample rate and cut to maxNumTaps. Returns
+        false if the file cannot be read.
+    */
+    bool loadImpulseResponse (const File& file, int firstChannel = -1);
+
+    /** Removes all loaded kernels, which silences the ChannelKernels mode. */
+    void clearImpulseResponses ();
+
+    /** Timing of every realtime call to process(), including the coefficient swaps. */
+    LoadMeter& getLoadMeter () { return loadMeter; }
+
+    double getSampleRate () const { return processor.getSampleRate (); }
+
+    /** The first channel's input and output of process(), for displays. */
+    SignalTap& getSignalTap () { return signalTap; }
+
+    /** Any thread but the audio thread: the coefficients of the set last handed to the audio
+        thread and the rate they run at, which is higher than the host's when oversampling.
+        The ChannelKernels mode gives the first channel's kernel at its file's rate; the
+        FilterBank mode has no single set and gives nullptr.
+    */
+    Coefficients::Ptr getActiveCoefficients (double& sampleRate) const;
+
+    /** Changes whenever getActiveCoefficients() does. */
+    uint32 getActiveCoefficientsVersion () const { return activeCoefficientsVersion.load (); }
+
 private:
+    /** Everything the audio thread needs for one design, built completely on the designing
+        thread so that switching to it only exchanges references. Only the engine picked by
+        mode gets its data; the direct filters start with a cleared history.
+    */
+    struct FilterSet
+    {
+        Mode mode { Mode::direct };
+        DirectConvolution::Symmetry symmetry { DirectConvolution::Symmetry::none };
+        int crossfadeSamples = 0;
+
+        Coefficients::Ptr coefficients;
+        OwnedArray<Filter> directFilters;
+        InterleavedConvolution::ExpandedCoefficients::Ptr interleavedCoefficients;
+        PartitionedImpulseResponse::Ptr impulseResponse;
+        NonUniformImpulseResponse::Ptr nonUniformImpulseResponse;
+        FilterBankResponses::Ptr bankResponses;
+        KernelStore::Ptr kernels;
+        ResamplingCascade::Ptr resampling;
+    };
+
+    /** The parameter values a design depends on, read on the message thread. */
+    struct DesignParameters
+    {
+        int function = 0;
+        int order = 21;
+        float frequency = 1000.f;
+        float transitionWidth = 0.f;
+        float amplitude = -100.f;
+        float spline = 0.f;
+        int windowType = 0;
+        float stopBandWeight = 1.f;
+        Mode mode { Mode::direct };
+        float crossfadeTime = 50.f;
+        int numBands = 4;
+        int resampling = 0;
+        bool minimumPhase = false;
+        bool allowLatency = false;
+        int accumulation = 0;
+        int latencyOffset = 0;
+    };
+
+    /** A loaded impulse response at its file's sample rate. */
+    struct KernelSource
+    {
+        std::vector<float> taps;
+        double sampleRate = 0.0;
+        int storeIndex = -1;    // where the current kernel store holds its spectra
+    };
+
+    /** Runs one design on the thread pool. Superseded jobs return without publishing. */
+    class DesignJob : public ThreadPoolJob
+    {
+    public:
+        DesignJob (FirFilter& f, const DesignParameters& p, uint32 g)
+            : ThreadPoolJob ("FIR design"), owner (f), parameters (p), generation (g) {}
+
+        JobStatus runJob () override
+        {
+            owner.designFilter (parameters, generation);
+            return jobHasFinished;
+        }
+
+    private:
+        FirFilter& owner;
+        DesignParameters parameters;
+        uint32 generation;
+    };
+
+    /** Hands the latency of a published design to the host. Designs run on the thread pool,
+        but hosts expect setLatencySamples() on the message thread or in prepareToPlay().
+    */
+    class LatencyReporter : private AsyncUpdater
+    {
+    public:
+        LatencyReporter (AudioProcessor& p) : processor (p) {}
+
+        /** Any thread; a later report before the message thread gets to it replaces this one. */
+        void report (int latencySamples)
+        {
+            latency = latencySamples;
+            triggerAsyncUpdate ();
+        }
+
+        /** Passes a pending report on straight away, for the synchronous design in prepare(). */
+        void flush () { handleUpdateNowIfNeeded (); }
+
+    private:
+        void handleAsyncUpdate () override { processor.setLatencySamples (latency.load ()); }
+
+        AudioProcessor& processor;
+        std::atomic<int> latency { 0 };
+    };
+
+    /** One complete set of engines with its own history. In realtime use a single lane
+        processes every channel; when rendering offline each channel gets a lane of its own,
+        so that the channels can be spread over the thread pool.
+    */
+    struct Lane
+    {
+        DirectConvolution simdFilter;
+        InterleavedConvolution interleavedFilter;
+        UniformPartitionedConvolution partitionedConvolution;
+        NonUniformPartitionedConvolution nonUniformConvolution;
+        FilterBank filterBank;
+        PolyphaseResampler resampler;
+
+        // read once a block; the filter bank ramps between the values across each frame
+        SmoothedValue<SampleType> bandGains[FilterBank::maxNumBands];
+
+        Mode mode { Mode::direct };
+        int resamplingStages = 0;
+        int firstChannel = 0;
+    };
+
+    /** Helps the rendering thread process the lanes of one block. */
+    class RenderJob : public ThreadPoolJob
+    {
+    public:
+        RenderJob (FirFilter& f) : ThreadPoolJob ("FIR render"), owner (f) {}
+
+        JobStatus runJob () override
+        {
+            owner.processPendingLanes ();
+            return jobHasFinished;
+        }
+
+    private:
+        FirFilter& owner;
+    };
+
     AudioProcessor& processor;
     HashMap<String, RangedAudioParameter*> parameters;
+    Array<AudioParameterFloat*> bandGains;
+    AudioParameterChoice* accumulation = nullptr;   // read by SIMD Direct and Morph; redesigns only in Auto
     
-    dsp::ProcessorDuplicator<Filter, Coefficients> filter;
-    dsp::DelayLine<SampleType> delayLine{ 8192 };
+    OwnedArray<Lane> lanes;
+    dsp::DelayLine<SampleType> delayLine{ maxNumTaps };
+    AudioBuffer<SampleType> conversionBuffer;
 
     dsp::ProcessSpec specs;
+    ConvolutionPlanner planner;
+    std::optional<ConvolutionPlanner::Strategy> automaticStrategy;  // what Auto picked last, guarded by designLock
     
-    SpinLock swapLock;
+    // held only to read the lanes and their configuration and to publish; design jobs check designGeneration instead
+    CriticalSection designLock;
+    DesignCache designCache;
+    RealtimeHandover<FilterSet> filterSets;
+    ReleasePool releasePool;
     
     ThreadPool threadPool;
+    std::atomic<uint32> designGeneration { 0 };
+    LatencyReporter latencyReporter { processor };
+
+    LoadMeter loadMeter;
+    SignalTap signalTap;
+
+    CriticalSection activeCoefficientsLock;
+    Coefficients::Ptr activeCoefficients;
+    double activeSampleRate = 0.0;
+    std::atomic<uint32> activeCoefficientsVersion { 0 };
+
+    // the block being rendered offline; lanes are claimed one at a time by whichever thread gets there first
+    OwnedArray<RenderJob> renderJobs;
+    const FilterSet* renderSet = nullptr;
+    Block renderBlock;
+    std::atomic<int> nextLane { 0 };
 
-    Coefficients::Ptr newCoefficients;
     Coefficients::Ptr oldCoefficients;
 
+    // loaded impulse responses and the channels using them. kernelLock is only held to change them or copy
+    // them out, so loading a file never waits for a design
+    CriticalSection kernelLock;
+    OwnedArray<KernelSource> kernelSources;
+    std::vector<int> channelKernels = std::vector<int> ((size_t)maxNumChannels, -1);
+    KernelStore::Ptr kernelStore;
+    double kernelStoreSampleRate = 0.0;
+    bool kernelStoreIsCurrent = false;
+    uint32 kernelSourcesVersion = 0;
+
     Atomic<bool> needsUpdate { false };
 
     template<typename T>
@@ -48,6 +284,20 @@ private:
             return defaultValue;
     }
 
+    Mode resolveMode (const DesignParameters& parameters, const Coefficients* coefficients, DirectConvolution::Symmetry symmetry);
+    void prepareLane (Lane& lane, const Spec& laneSpec);
+    void processLane (Lane& lane, const FilterSet& set, Context context);
+    void processAtInternalRate (Lane& lane, const FilterSet& set, Context context);
+    void processPendingLanes ();
+    void applyFilterSet (Lane& lane, const FilterSet& set);
+    DesignParameters getDesignParameters ();
+    static double getStopBandEdge (const DesignParameters& parameters, double sampleRate);
+    static int chooseResamplingStages (const DesignParameters& parameters, double sampleRate);
+    static DesignCache::Key getDesignKey (const DesignParameters& parameters, float frequency, double sampleRate);
+    void designFilter (const DesignParameters& parameters, uint32 generation);
+    void setActiveCoefficients (Coefficients::Ptr coefficients, double sampleRate);
+    KernelStore::Ptr updateKernelStore (double sampleRate, int partitionSize, Coefficients::Ptr& firstKernel, double& firstKernelRate);
     void updateFilter ();
     void handleAsyncUpdate () override;
+    void timerCallback () override;
 };
\ No newline at end of file
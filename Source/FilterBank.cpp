@@ -0,0 +1,287 @@
+#include "FilterBank.h"
+
+FilterBankResponses::FilterBankResponses (const std::vector<float>& crossoverFrequencies, double sampleRate, int numTaps,
+                                          DigitalFilter::FIRFilterWindowType window, float stopBandAttenuation, int partitionSize)
+{
+    jassert (! crossoverFrequencies.empty ());
+    jassert ((int)crossoverFrequencies.size () < FilterBank::maxNumBands);
+
+    const auto numBands = (int)crossoverFrequencies.size () + 1;
+    const auto fs = (float)sampleRate;
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        auto design = [&]
+        {
+            using namespace DigitalFilter;
+
+            if (b == 0)
+                return std::make_unique<FIRFilter> (LowPass, window, numTaps, fs, crossoverFrequencies.front (), 0.0f, stopBandAttenuation);
+
+            if (b == numBands - 1)
+                return std::make_unique<FIRFilter> (HighPass, window, numTaps, fs, crossoverFrequencies.back (), 0.0f, stopBandAttenuation);
+
+            return std::make_unique<FIRFilter> (BandPass, window, numTaps, fs, crossoverFrequencies[(size_t)b - 1],
+                                                crossoverFrequencies[(size_t)b], stopBandAttenuation);
+        }();
+
+        bands.emplace_back (new PartitionedImpulseResponse (design->GetImpulseResponse ().data (), numTaps, partitionSize));
+    }
+}
+
+//==============================================================================
+void FilterBank::prepare (const Spec& spec, int size, int maxNumTaps)
+{
+    jassert (isPowerOfTwo (size));
+
+    partitionSize = size;
+    numBins = partitionSize + 1;
+    numSlots = jmax (1, (maxNumTaps + partitionSize - 1) / partitionSize);
+
+    const auto fftSize = 2 * partitionSize;
+    fft = std::make_unique<dsp::FFT> (roundToInt (std::log2 (fftSize)));
+    fftBuffer.allocate ((size_t)fftSize * 2, true);
+    accumulator.allocate ((size_t)numBins * 2, true);
+    rampBuffer.allocate ((size_t)partitionSize, true);
+    ramp.allocate ((size_t)partitionSize, false);
+    mixedSpectra.allocate ((size_t)numSlots * 2 * (size_t)numBins, true);
+    targetSpectra.allocate ((size_t)numSlots * 2 * (size_t)numBins, true);
+
+    for (int i = 0; i < partitionSize; ++i)
+        ramp[i] = (float)(i + 1) / (float)partitionSize;
+
+    channels.resize (spec.numChannels);
+
+    for (auto& channel : channels)
+    {
+        channel.input.allocate ((size_t)fftSize, true);
+        channel.output.allocate ((size_t)maxNumBands * (size_t)partitionSize, true);
+        channel.delayLine.allocate ((size_t)numSlots * 2 * (size_t)numBins, true);
+    }
+
+    reset ();
+}
+
+void FilterBank::setResponses (FilterBankResponses::Ptr newResponses)
+{
+    jassert (newResponses == nullptr || newResponses->getNumBands () <= maxNumBands);
+    jassert (newResponses == nullptr || newResponses->bands.front ()->partitionSize == partitionSize);
+
+    std::swap (responses, newResponses);
+    hasMixedSpectra = false;
+}
+
+void FilterBank::reset ()
+{
+    for (auto& channel : channels)
+    {
+        channel.input.clear ((size_t)partitionSize * 2);
+        channel.output.clear ((size_t)maxNumBands * (size_t)partitionSize);
+        channel.delayLine.clear ((size_t)numSlots * 2 * (size_t)numBins);
+        channel.delayLineIndex = 0;
+    }
+
+    framePosition = 0;
+    hasFrameGains = false;
+    hasMixedSpectra = false;
+}
+
+void FilterBank::process (const dsp::AudioBlock<const SampleType>& input, dsp::AudioBlock<SampleType>* bandOutputs)
+{
+    const auto numBands = responses != nullptr ? responses->getNumBands () : 0;
+
+    processBlock (input, numBands, nullptr, [bandOutputs] (int band, size_t channel) { return bandOutputs[band].getChannelPointer (channel); });
+}
+
+void FilterBank::process (const Context& context, const SampleType* gains)
+{
+    auto& outputBlock = context.getOutputBlock ();
+
+    processBlock (context.getInputBlock (), 1, gains, [&outputBlock] (int, size_t channel) { return outputBlock.getChannelPointer (channel); });
+}
+
+template <typename OutputFunction>
+void FilterBank::processBlock (const dsp::AudioBlock<const SampleType>& input, int numOutputs, const SampleType* gains, OutputFunction getOutput)
+{
+    const auto numChannels = jmin (input.getNumChannels (), channels.size ());
+    const auto numSamples = (int)input.getNumSamples ();
+
+    int done = 0;
+    int position = framePosition;
+
+    while (done < numSamples)
+    {
+        const auto numThisTime = jmin (numSamples - done, partitionSize - position);
+        const auto completesFrame = position + numThisTime == partitionSize;
+
+        if (completesFrame && gains != nullptr)
+            prepareMixedFrame (gains);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channel = channels[ch];
+
+            // input is stored before any output is written, so in place processing is fine
+            FloatVectorOperations::copy (channel.input + partitionSize + position, input.getChannelPointer (ch) + done, numThisTime);
+
+            for (int b = 0; b < numOutputs; ++b)
+                FloatVectorOperations::copy (getOutput (b, ch) + done, channel.output + b * partitionSize + position, numThisTime);
+
+            if (completesFrame)
+                processFrame (channel, gains);
+        }
+
+        if (completesFrame && gains != nullptr)
+            finishMixedFrame (gains);
+
+        position = (position + numThisTime) % partitionSize;
+        done += numThisTime;
+    }
+
+    framePosition = position;
+}
+
+void FilterBank::prepareMixedFrame (const SampleType* gains)
+{
+    const auto numBands = responses != nullptr ? responses->getNumBands () : 0;
+
+    // after a reset the first frame starts at the requested gains instead of ramping up from silence
+    if (! hasFrameGains)
+    {
+        std::copy (gains, gains + maxNumBands, frameGains.begin ());
+        hasFrameGains = true;
+        hasMixedSpectra = false;
+    }
+
+    if (! hasMixedSpectra)
+    {
+        mixSpectra (mixedSpectra.get (), frameGains.data ());
+        hasMixedSpectra = true;
+    }
+
+    isRamping = ! std::equal (gains, gains + numBands, frameGains.begin ());
+
+    if (isRamping)
+        mixSpectra (targetSpectra.get (), gains);
+}
+
+void FilterBank::finishMixedFrame (const SampleType* gains)
+{
+    // every channel has ramped to the new gains, so the next frame starts from them
+    if (isRamping)
+        mixedSpectra.swapWith (targetSpectra);
+
+    std::copy (gains, gains + maxNumBands, frameGains.begin ());
+    isRamping = false;
+}
+
+void FilterBank::mixSpectra (float* destination, const SampleType* gains) const
+{
+    const auto spectrumSize = 2 * numBins;
+    const auto numBands = responses != nullptr ? responses->getNumBands () : 0;
+
+    FloatVectorOperations::clear (destination, numSlots * spectrumSize);
+
+    // a band's partitions are stored back to back, so each band is one pass over its spectra
+    for (int b = 0; b < numBands; ++b)
+    {
+        const auto& band = *responses->bands[(size_t)b];
+
+        if (gains[b] != 0.0f)
+            FloatVectorOperations::addWithMultiply (destination, band.spectra.get (), gains[b],
+                                                    jmin (band.numPartitions, numSlots) * spectrumSize);
+    }
+}
+
+void FilterBank::processFrame (Channel& channel, const SampleType* gains)
+{
+    const auto fftSize = 2 * partitionSize;
+    const auto spectrumSize = 2 * numBins;
+
+    FloatVectorOperations::copy (fftBuffer.get (), channel.input.get (), fftSize);
+    FloatVectorOperations::clear (fftBuffer + fftSize, fftSize);
+    fft->performRealOnlyForwardTransform (fftBuffer.get (), true);
+
+    // the one forward transform all bands share
+    channel.delayLineIndex = (channel.delayLineIndex + 1) % numSlots;
+
+    auto* slotRe = channel.delayLine + (size_t)channel.delayLineIndex * (size_t)spectrumSize;
+    auto* slotIm = slotRe + numBins;
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        slotRe[k] = fftBuffer[2 * k];
+        slotIm[k] = fftBuffer[2 * k + 1];
+    }
+
+    const auto numBands = responses != nullptr ? responses->getNumBands () : 0;
+    const auto numPartitions = numBands > 0 ? jmin (responses->bands.front ()->numPartitions, numSlots) : 0;
+
+    if (gains != nullptr)
+    {
+        FloatVectorOperations::clear (accumulator.get (), spectrumSize);
+        multiplyAccumulate (channel, mixedSpectra.get (), numPartitions);
+        inverseTransform (channel.output.get ());
+
+        // output + ramp * (new output - output), so the frame ends exactly at the new gains
+        if (isRamping)
+        {
+            FloatVectorOperations::clear (accumulator.get (), spectrumSize);
+            multiplyAccumulate (channel, targetSpectra.get (), numPartitions);
+            inverseTransform (rampBuffer.get ());
+
+            FloatVectorOperations::subtract (rampBuffer.get (), channel.output.get (), partitionSize);
+            FloatVectorOperations::addWithMultiply (channel.output.get (), rampBuffer.get (), ramp.get (), partitionSize);
+        }
+    }
+    else
+    {
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto& band = *responses->bands[(size_t)b];
+
+            FloatVectorOperations::clear (accumulator.get (), spectrumSize);
+            multiplyAccumulate (channel, band.spectra.get (), jmin (band.numPartitions, numSlots));
+            inverseTransform (channel.output + b * partitionSize);
+        }
+    }
+
+    FloatVectorOperations::copy (channel.input.get (), channel.input + partitionSize, partitionSize);
+}
+
+void FilterBank::multiplyAccumulate (const Channel& channel, const float* spectra, int numPartitions)
+{
+    const auto spectrumSize = 2 * numBins;
+
+    auto* accRe = accumulator.get ();
+    auto* accIm = accumulator + numBins;
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto slot = (channel.delayLineIndex - p + numSlots) % numSlots;
+        const auto* xRe = channel.delayLine + (size_t)slot * (size_t)spectrumSize;
+        const auto* xIm = xRe + numBins;
+        const auto* hRe = spectra + (size_t)p * (size_t)spectrumSize;
+        const auto* hIm = hRe + numBins;
+
+        // the complex product of the split spectra, as four vector multiply-adds
+        FloatVectorOperations::addWithMultiply (accRe, xRe, hRe, numBins);
+        FloatVectorOperations::subtractWithMultiply (accRe, xIm, hIm, numBins);
+        FloatVectorOperations::addWithMultiply (accIm, xRe, hIm, numBins);
+        FloatVectorOperations::addWithMultiply (accIm, xIm, hRe, numBins);
+    }
+}
+
+void FilterBank::inverseTransform (float* output)
+{
+    for (int k = 0; k < numBins; ++k)
+    {
+        fftBuffer[2 * k] = accumulator[k];
+        fftBuffer[2 * k + 1] = accumulator[numBins + k];
+    }
+
+    fft->performRealOnlyInverseTransform (fftBuffer.get ());
+
+    // overlap-save: only the second half of the circular convolution is valid
+    FloatVectorOperations::copy (output, fftBuffer + partitionSize, partitionSize);
+}
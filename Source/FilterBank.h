@@ -0,0 +1,109 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolution.h"
+#include "DigitalFilter.h"
+
+/** The partition spectra of every band of a linear-phase crossover.
+
+    Band 0 is a lowpass at the first crossover frequency, the last band a highpass at the
+    last one, and the bands in between are band-passes between neighbouring crossovers, all
+    designed by DigitalFilter::FIRFilter with the same window and length. The ideal band
+    responses add up to a pure delay, so the bands sum back to the delayed input.
+*/
+struct FilterBankResponses : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<FilterBankResponses>;
+
+    FilterBankResponses (const std::vector<float>& crossoverFrequencies, double sampleRate, int numTaps,
+                         DigitalFilter::FIRFilterWindowType window, float stopBandAttenuation, int partitionSize);
+
+    int getNumBands () const { return (int)bands.size (); }
+
+    std::vector<PartitionedImpulseResponse::Ptr> bands;
+};
+
+/** Uniformly-partitioned overlap-save filter bank.
+
+    All bands share one input history and one frequency-domain delay line per channel, so
+    each frame of input is transformed only once. Splitting into separate band outputs then
+    costs a multiply-accumulate and an inverse FFT per band. The mixed output instead sums
+    the bands' partition spectra, weighted by their gains, into one set that is rebuilt only
+    when a gain changes; each frame is then a single convolution however many bands there are.
+
+    The band gains only enter at frame boundaries, so a change is spread over the next frame:
+    while the gains move, the frame is also convolved with a set mixed from the new gains and
+    the output crossfades from the old result to the new one. Steady gains cost nothing extra.
+
+    Use either the split or the mixed process() on one instance, not both. The latency is
+    always exactly partitionSize samples, on top of the delay of the band responses.
+*/
+class FilterBank
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+
+    static constexpr int maxNumBands = 8;
+
+    void prepare (const Spec& spec, int partitionSize, int maxNumTaps);
+
+    /** Swaps in a new set of band responses. Does not allocate, call from the audio thread. */
+    void setResponses (FilterBankResponses::Ptr newResponses);
+
+    void reset ();
+
+    /** Writes band b of every input channel to bandOutputs[b], for all bands of the current responses. */
+    void process (const dsp::AudioBlock<const SampleType>& input, dsp::AudioBlock<SampleType>* bandOutputs);
+
+    /** Replaces the block with the sum of all bands, band b scaled by gains[b]. gains holds maxNumBands
+        values; after a reset the first frame starts at them, later frames ramp to them from the last ones.
+    */
+    void process (const Context& context, const SampleType* gains);
+
+    int getPartitionSize () const { return partitionSize; }
+    int getLatencyInSamples () const { return partitionSize; }
+
+private:
+    struct Channel
+    {
+        HeapBlock<float> input;     // last 2 * partitionSize input samples
+        HeapBlock<float> output;    // partitionSize samples per band produced by the last frame
+        HeapBlock<float> delayLine; // numSlots spectra, split real / imaginary
+        int delayLineIndex = 0;
+    };
+
+    template <typename OutputFunction>
+    void processBlock (const dsp::AudioBlock<const SampleType>& input, int numOutputs, const SampleType* gains, OutputFunction getOutput);
+
+    void prepareMixedFrame (const SampleType* gains);
+    void finishMixedFrame (const SampleType* gains);
+    void mixSpectra (float* destination, const SampleType* gains) const;
+
+    void processFrame (Channel& channel, const SampleType* gains);
+    void multiplyAccumulate (const Channel& channel, const float* spectra, int numPartitions);
+    void inverseTransform (float* output);
+
+    std::unique_ptr<dsp::FFT> fft;
+    HeapBlock<float> fftBuffer;
+    HeapBlock<float> accumulator;
+    HeapBlock<float> rampBuffer;    // the output with the new gains, crossfaded in across the frame
+    HeapBlock<float> ramp;          // 1 / partitionSize up to 1
+
+    // the band spectra summed with frameGains, and with the new gains while they move
+    HeapBlock<float> mixedSpectra, targetSpectra;
+    std::array<float, maxNumBands> frameGains {};   // the gains the last frame ended with
+    bool hasFrameGains = false;
+    bool hasMixedSpectra = false;
+    bool isRamping = false;
+
+    std::vector<Channel> channels;
+
+    FilterBankResponses::Ptr responses;
+
+    int partitionSize = 0;
+    int numBins = 0;
+    int numSlots = 0;
+    int framePosition = 0;
+};
@@ -0,0 +1,506 @@
+#include "FilterDesigner.h"
+
+namespace
+{
+    /** Barycentric weights 1 / prod (x[k] - x[j]) for all k, scaled by a common factor.
+
+        The products over thousands of nodes would overflow a double, so the exponent is
+        split off with frexp as they are accumulated. The common scale cancels in every
+        formula the weights are used in.
+    */
+    void computeBarycentricWeights (const double* x, int numPoints, double* weights)
+    {
+        std::vector<double> mantissas ((size_t)numPoints);
+        std::vector<int> exponents ((size_t)numPoints);
+        auto largestExponent = std::numeric_limits<int>::min ();
+
+        for (int k = 0; k < numPoints; ++k)
+        {
+            auto mantissa = 1.0;
+            auto exponent = 0;
+
+            for (int j = 0; j < numPoints; ++j)
+            {
+                if (j == k)
+                    continue;
+
+                mantissa *= x[k] - x[j];
+
+                if ((j & 15) == 0)
+                {
+                    int e;
+                    mantissa = std::frexp (mantissa, &e);
+                    exponent += e;
+                }
+            }
+
+            int e;
+            mantissa = std::frexp (mantissa, &e);
+            exponent += e;
+
+            mantissas[(size_t)k] = 1.0 / mantissa;
+            exponents[(size_t)k] = -exponent;
+            largestExponent = jmax (largestExponent, -exponent);
+        }
+
+        for (int k = 0; k < numPoints; ++k)
+            weights[k] = std::ldexp (mantissas[(size_t)k], exponents[(size_t)k] - largestExponent);
+    }
+
+    /** Evaluates the polynomial through (x[k], y[k]) at xValue with the second barycentric formula. */
+    double interpolate (double xValue, const double* x, const double* y, const double* weights, int numPoints)
+    {
+        auto numerator = 0.0;
+        auto denominator = 0.0;
+
+        for (int k = 0; k < numPoints; ++k)
+        {
+            const auto difference = xValue - x[k];
+
+            if (std::abs (difference) < 1.0e-14)
+                return y[k];
+
+            const auto t = weights[k] / difference;
+            numerator += t * y[k];
+            denominator += t;
+        }
+
+        return numerator / denominator;
+    }
+
+    FilterDesigner::Coefficients::Ptr createSymmetricCoefficients (const std::vector<double>& taps)
+    {
+        const auto numTaps = taps.size ();
+        FilterDesigner::Coefficients::Ptr result = new FilterDesigner::Coefficients (numTaps);
+        auto* c = result->getRawCoefficients ();
+
+        // average the mirrored taps so that rounding does not hide the symmetry from the folded kernels
+        for (size_t i = 0; i < numTaps; ++i)
+            c[i] = (float)(0.5 * (taps[i] + taps[numTaps - 1 - i]));
+
+        return result;
+    }
+
+    /** In-place radix-2 FFT in double precision; the cepstrum needs more dynamic range than
+        float transforms give once the stop band is below about -120 dB.
+    */
+    void transform (std::vector<std::complex<double>>& data, bool inverse)
+    {
+        const auto size = data.size ();
+
+        for (size_t i = 1, j = 0; i < size; ++i)
+        {
+            auto bit = size >> 1;
+
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+
+            j ^= bit;
+
+            if (i < j)
+                std::swap (data[i], data[j]);
+        }
+
+        for (size_t length = 2; length <= size; length <<= 1)
+        {
+            const auto angle = (inverse ? 2.0 : -2.0) * MathConstants<double>::pi / (double)length;
+            const std::complex<double> step (std::cos (angle), std::sin (angle));
+
+            for (size_t start = 0; start < size; start += length)
+            {
+                std::complex<double> twiddle (1.0, 0.0);
+
+                for (size_t k = 0; k < length / 2; ++k)
+                {
+                    const auto a = data[start + k];
+                    const auto b = data[start + k + length / 2] * twiddle;
+
+                    data[start + k] = a + b;
+                    data[start + k + length / 2] = a - b;
+
+                    // resynchronise now and then so the recurrence does not drift on long transforms
+                    twiddle = (k & 63) == 63 ? std::polar (1.0, angle * (double)(k + 1)) : twiddle * step;
+                }
+            }
+        }
+
+        if (inverse)
+            for (auto& value : data)
+                value /= (double)size;
+    }
+}
+
+
+//==============================================================================
+bool FilterDesigner::solveSymmetricToeplitz (const double* r, const double* b, double* x, int n)
+{
+    if (n <= 0 || r[0] <= 0.0)
+        return false;
+
+    // Levinson recursion on the matrix normalised to a unit diagonal, see Golub & Van Loan 4.7.3
+    std::vector<double> t ((size_t)n), y ((size_t)n), temp ((size_t)n);
+
+    for (int i = 0; i < n; ++i)
+        t[(size_t)i] = r[i] / r[0];
+
+    x[0] = b[0] / r[0];
+
+    if (n == 1)
+        return true;
+
+    auto alpha = -t[1];
+    auto beta = 1.0;
+    y[0] = alpha;
+
+    for (int k = 1; k < n; ++k)
+    {
+        beta *= 1.0 - alpha * alpha;
+
+        if (beta <= 0.0)
+            return false;
+
+        auto dot = 0.0;
+
+        for (int i = 1; i <= k; ++i)
+            dot += t[(size_t)i] * x[k - i];
+
+        const auto mu = (b[k] / r[0] - dot) / beta;
+
+        for (int i = 0; i < k; ++i)
+            temp[(size_t)i] = x[i] + mu * y[(size_t)(k - 1 - i)];
+
+        std::copy (temp.begin (), temp.begin () + k, x);
+        x[k] = mu;
+
+        if (k == n - 1)
+            break;
+
+        dot = 0.0;
+
+        for (int i = 1; i <= k; ++i)
+            dot += t[(size_t)i] * y[(size_t)(k - i)];
+
+        alpha = -(t[(size_t)(k + 1)] + dot) / beta;
+
+        for (int i = 0; i < k; ++i)
+            temp[(size_t)i] = y[(size_t)i] + alpha * y[(size_t)(k - 1 - i)];
+
+        std::copy (temp.begin (), temp.begin () + k, y.begin ());
+        y[(size_t)k] = alpha;
+    }
+
+    return true;
+}
+
+FilterDesigner::Coefficients::Ptr FilterDesigner::designFIRLowpassLeastSquaresMethod (float frequency, double sampleRate, size_t order,
+                                                                                   float normalisedTransitionWidth, float stopBandWeight)
+{
+    const auto pi = MathConstants<double>::pi;
+    const auto normalisedFrequency = frequency / sampleRate;
+
+    const auto wp = jlimit (0.0, pi, MathConstants<double>::twoPi * (normalisedFrequency - normalisedTransitionWidth / 2.0));
+    const auto ws = jlimit (wp, pi, MathConstants<double>::twoPi * (normalisedFrequency + normalisedTransitionWidth / 2.0));
+    const auto weight = (double)stopBandWeight;
+
+    const auto numTaps = (int)order + 1;
+    const auto centre = (numTaps - 1) / 2.0;
+
+    // R[i][j] = 1/pi * integral of W(w) cos ((i - j) w), p[i] = 1/pi * integral over the pass band of cos ((i - centre) w)
+    std::vector<double> r ((size_t)numTaps), p ((size_t)numTaps), h ((size_t)numTaps);
+
+    r[0] = (wp + weight * (pi - ws)) / pi;
+
+    for (int k = 1; k < numTaps; ++k)
+        r[(size_t)k] = (std::sin (k * wp) - weight * std::sin (k * ws)) / (pi * k);
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        const auto distance = i - centre;
+        p[(size_t)i] = distance == 0.0 ? wp / pi : std::sin (distance * wp) / (pi * distance);
+    }
+
+    // wide transition bands make the matrix nearly singular, a little diagonal loading keeps it definite
+    r[0] *= 1.0 + 1.0e-12;
+
+    if (! solveSymmetricToeplitz (r.data (), p.data (), h.data (), numTaps))
+    {
+        r[0] *= 1.0 + 1.0e-8;
+
+        if (! solveSymmetricToeplitz (r.data (), p.data (), h.data (), numTaps))
+            return nullptr;
+    }
+
+    return createSymmetricCoefficients (h);
+}
+
+FilterDesigner::Coefficients::Ptr FilterDesigner::makeMinimumPhase (const Coefficients& coefficients)
+{
+    const auto numTaps = (int)coefficients.getFilterSize ();
+    const auto* h = coefficients.getRawCoefficients ();
+
+    if (numTaps < 2)
+        return new Coefficients (h, (size_t)numTaps);
+
+    // the cepstrum of a sharp filter decays slowly, and its aliasing is what fills up the stop band,
+    // so it is computed with plenty of padding
+    const auto size = (size_t)jlimit (1 << 16, 1 << 20, nextPowerOfTwo (numTaps) * 64);
+    std::vector<std::complex<double>> data (size);
+
+    for (int i = 0; i < numTaps; ++i)
+        data[(size_t)i] = h[i];
+
+    transform (data, false);
+
+    auto peak = 0.0;
+
+    for (auto& value : data)
+        peak = jmax (peak, std::abs (value));
+
+    if (peak == 0.0)
+        return new Coefficients (h, (size_t)numTaps);
+
+    // zeros on the unit circle have no logarithm, so the magnitude is floored at -200 dB
+    const auto floor = peak * 1.0e-10;
+
+    for (auto& value : data)
+        value = std::log (jmax (floor, std::abs (value)));
+
+    transform (data, true);
+
+    // folding the real cepstrum onto positive quefrencies gives the minimum-phase log spectrum
+    for (size_t n = 1; n < size / 2; ++n)
+        data[n] = 2.0 * data[n].real ();
+
+    data[0] = data[0].real ();
+    data[size / 2] = data[size / 2].real ();
+    std::fill (data.begin () + (std::ptrdiff_t)(size / 2) + 1, data.end (), 0.0);
+
+    transform (data, false);
+
+    for (auto& value : data)
+        value = std::exp (value);
+
+    transform (data, true);
+
+    Coefficients::Ptr result = new Coefficients ((size_t)numTaps);
+    auto* c = result->getRawCoefficients ();
+
+    for (int i = 0; i < numTaps; ++i)
+        c[i] = (float)data[(size_t)i].real ();
+
+    return result;
+}
+
+FilterDesigner::Coefficients::Ptr FilterDesigner::designFIRLowpassEquirippleMethod (float frequency, double sampleRate, size_t order,
+                                                                                 float normalisedTransitionWidth, float stopBandWeight)
+{
+    const auto normalisedFrequency = frequency / sampleRate;
+    const auto passBandEdge = jlimit (0.0, 0.5, normalisedFrequency - normalisedTransitionWidth / 2.0);
+    const auto stopBandEdge = jlimit (passBandEdge, 0.5, normalisedFrequency + normalisedTransitionWidth / 2.0);
+
+    const std::vector<Band> bands { { 0.0, passBandEdge, 1.0, 1.0 },
+                                    { stopBandEdge, 0.5, 0.0, jmax (1.0e-3, (double)stopBandWeight) } };
+
+    if (auto result = designFIREquiripple ((int)order + 1, bands))
+        return result;
+
+    // too few grid points for the exchange, the least squares solution is the closest there is
+    return designFIRLowpassLeastSquaresMethod (frequency, sampleRate, order, normalisedTransitionWidth, stopBandWeight);
+}
+
+FilterDesigner::Coefficients::Ptr FilterDesigner::designFIREquiripple (int numTaps, const std::vector<Band>& bands, int maxIterations)
+{
+    if (numTaps < 3 || bands.empty ())
+        return nullptr;
+
+    const auto isOdd = numTaps % 2 == 1;
+
+    // A(f) is a cosine series with numTerms terms; even lengths carry an extra cos (pi f) factor
+    const auto numTerms = isOdd ? (numTaps + 1) / 2 : numTaps / 2;
+    const auto numExtremals = numTerms + 1;
+
+    constexpr int gridDensity = 16;
+    const auto spacing = 0.5 / (gridDensity * numTerms);
+
+    std::vector<double> gridX, desired, weight;
+    std::vector<std::pair<int, int>> bandRanges;
+
+    for (auto& band : bands)
+    {
+        const auto start = jlimit (0.0, 0.5, band.startFrequency);
+        auto end = jlimit (start, 0.5, band.endFrequency);
+
+        // cos (pi f) vanishes at 0.5, so even lengths cannot be fitted there
+        if (! isOdd)
+            end = jmin (end, 0.5 - spacing);
+
+        if (end < start)
+            continue;
+
+        const auto numPoints = jmax (1, (int)std::ceil ((end - start) / spacing) + 1);
+        const auto first = (int)gridX.size ();
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto f = numPoints > 1 ? start + (end - start) * i / (numPoints - 1) : start;
+            const auto factor = isOdd ? 1.0 : std::cos (MathConstants<double>::pi * f);
+
+            gridX.push_back (std::cos (MathConstants<double>::twoPi * f));
+            desired.push_back (band.gain / factor);
+            weight.push_back (band.weight * factor);
+        }
+
+        bandRanges.emplace_back (first, (int)gridX.size () - 1);
+    }
+
+    const auto gridSize = (int)gridX.size ();
+
+    if (gridSize < numExtremals)
+        return nullptr;
+
+    std::vector<int> extremals ((size_t)numExtremals);
+
+    for (int i = 0; i < numExtremals; ++i)
+        extremals[(size_t)i] = (int)((int64)i * (gridSize - 1) / numTerms);
+
+    std::vector<double> x ((size_t)numExtremals), y ((size_t)numExtremals), weights ((size_t)numExtremals), error ((size_t)gridSize);
+    auto deviation = 0.0;
+
+    for (int iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        for (int k = 0; k < numExtremals; ++k)
+            x[(size_t)k] = gridX[(size_t)extremals[(size_t)k]];
+
+        computeBarycentricWeights (x.data (), numExtremals, weights.data ());
+
+        // the deviation that makes the weighted error alternate exactly on the current extremals
+        auto numerator = 0.0;
+        auto denominator = 0.0;
+
+        for (int k = 0; k < numExtremals; ++k)
+        {
+            const auto sign = k % 2 == 0 ? 1.0 : -1.0;
+            numerator += weights[(size_t)k] * desired[(size_t)extremals[(size_t)k]];
+            denominator += sign * weights[(size_t)k] / weight[(size_t)extremals[(size_t)k]];
+        }
+
+        deviation = numerator / denominator;
+
+        // interpolate through the first numTerms extremals, whose weights follow from the full set
+        for (int k = 0; k < numTerms; ++k)
+        {
+            const auto sign = k % 2 == 0 ? 1.0 : -1.0;
+            y[(size_t)k] = desired[(size_t)extremals[(size_t)k]] - sign * deviation / weight[(size_t)extremals[(size_t)k]];
+            weights[(size_t)k] *= x[(size_t)k] - x[(size_t)numTerms];
+        }
+
+        for (int i = 0; i < gridSize; ++i)
+            error[(size_t)i] = weight[(size_t)i] * (desired[(size_t)i] - interpolate (gridX[(size_t)i], x.data (), y.data (), weights.data (), numTerms));
+
+        // local extrema of the error within each band
+        std::vector<int> candidates;
+
+        for (auto [first, last] : bandRanges)
+        {
+            for (int i = first; i <= last; ++i)
+            {
+                const auto value = error[(size_t)i];
+                const auto sign = value < 0.0 ? -1.0 : 1.0;
+
+                if ((i == first || sign * value >= sign * error[(size_t)(i - 1)])
+                    && (i == last || sign * value > sign * error[(size_t)(i + 1)]))
+                    candidates.push_back (i);
+            }
+        }
+
+        // keep the signs alternating, preferring the larger of two neighbours with the same sign
+        std::vector<int> next;
+
+        for (auto i : candidates)
+        {
+            if (! next.empty () && (error[(size_t)i] < 0.0) == (error[(size_t)next.back ()] < 0.0))
+            {
+                if (std::abs (error[(size_t)i]) > std::abs (error[(size_t)next.back ()]))
+                    next.back () = i;
+            }
+            else
+            {
+                next.push_back (i);
+            }
+        }
+
+        while ((int)next.size () > numExtremals)
+        {
+            auto magnitude = [&] (size_t index) { return std::abs (error[(size_t)next[index]]); };
+
+            if ((int)next.size () == numExtremals + 1)
+            {
+                next.erase (magnitude (0) < magnitude (next.size () - 1) ? next.begin () : std::prev (next.end ()));
+                continue;
+            }
+
+            size_t smallest = 0;
+
+            for (size_t i = 1; i < next.size (); ++i)
+                if (magnitude (i) < magnitude (smallest))
+                    smallest = i;
+
+            next.erase (next.begin () + (std::ptrdiff_t)smallest);
+
+            // the two neighbours of an interior extremum now have the same sign, drop the smaller
+            if (smallest > 0 && smallest < next.size ())
+                next.erase (next.begin () + (std::ptrdiff_t)(magnitude (smallest - 1) < magnitude (smallest) ? smallest - 1 : smallest));
+        }
+
+        if ((int)next.size () < numExtremals)
+            break;
+
+        auto largest = 0.0;
+        auto smallest = std::numeric_limits<double>::max ();
+
+        for (auto i : next)
+        {
+            largest = jmax (largest, std::abs (error[(size_t)i]));
+            smallest = jmin (smallest, std::abs (error[(size_t)i]));
+        }
+
+        const auto converged = next == extremals || largest - smallest <= 1.0e-4 * largest;
+        extremals = next;
+
+        if (converged)
+            break;
+    }
+
+    // ripple below double precision makes the exchange fall apart instead of converging
+    auto largestError = 0.0;
+
+    for (auto e : error)
+        largestError = jmax (largestError, std::abs (e));
+
+    if (! std::isfinite (largestError) || largestError > 2.0 * std::abs (deviation) + 1.0e-6)
+        return nullptr;
+
+    // sample the frequency response of the last fit and transform it back into taps
+    const auto centre = (numTaps - 1) / 2.0;
+    const auto numSamples = (numTaps - 1) / 2;
+    std::vector<double> response ((size_t)numSamples + 1), taps ((size_t)numTaps);
+
+    for (int k = 0; k <= numSamples; ++k)
+    {
+        const auto f = (double)k / numTaps;
+        const auto factor = isOdd ? 1.0 : std::cos (MathConstants<double>::pi * f);
+        response[(size_t)k] = factor * interpolate (std::cos (MathConstants<double>::twoPi * f), x.data (), y.data (), weights.data (), numTerms);
+    }
+
+    for (int n = 0; n < (numTaps + 1) / 2; ++n)
+    {
+        auto sum = response[0];
+
+        for (int k = 1; k <= numSamples; ++k)
+            sum += 2.0 * response[(size_t)k] * std::cos (MathConstants<double>::twoPi * k * (n - centre) / numTaps);
+
+        taps[(size_t)n] = taps[(size_t)(numTaps - 1 - n)] = sum / numTaps;
+    }
+
+    return createSymmetricCoefficients (taps);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** FIR design methods that stay fast at high orders.
+
+    designFIRLowpassLeastSquaresMethod() minimises the same weighted squared error as
+    dsp::FilterDesign's version, but over all N taps instead of the folded half. The
+    normal equations then form a symmetric positive definite Toeplitz matrix, which
+    Levinson recursion solves in O(N^2) time and O(N) memory rather than the O(N^3) dense
+    solve of the Toeplitz-plus-Hankel system JUCE builds.
+
+    designFIREquiripple() is a Parks-McClellan / Remez exchange for linear-phase filters
+    with any number of bands. The interpolation uses barycentric weights whose exponents
+    are tracked separately, so thousands of extremal frequencies do not overflow.
+
+    All frequencies given in Band are normalised to the sample rate, i.e. 0 to 0.5.
+*/
+struct FilterDesigner
+{
+    using Coefficients = dsp::FIR::Coefficients<float>;
+
+    struct Band
+    {
+        double startFrequency;
+        double endFrequency;
+        double gain;
+        double weight;
+    };
+
+    /** Same specification and parameters as dsp::FilterDesign::designFIRLowpassLeastSquaresMethod.
+        Returns nullptr if the bands leave the problem without a unique solution.
+    */
+    static Coefficients::Ptr designFIRLowpassLeastSquaresMethod (float frequency, double sampleRate, size_t order,
+                                                                 float normalisedTransitionWidth, float stopBandWeight);
+
+    /** Equiripple lowpass with the same band layout as the least squares method. */
+    static Coefficients::Ptr designFIRLowpassEquirippleMethod (float frequency, double sampleRate, size_t order,
+                                                               float normalisedTransitionWidth, float stopBandWeight);
+
+    /** Symmetric equiripple filter with numTaps taps approximating the given bands.
+        Stops after maxIterations exchanges even if the ripple has not settled yet, and
+        returns nullptr if the exchange failed, e.g. because the ripple would be far below
+        the precision of a double.
+    */
+    static Coefficients::Ptr designFIREquiripple (int numTaps, const std::vector<Band>& bands, int maxIterations = 40);
+
+    /** Minimum-phase filter with the same number of taps and (nearly) the same magnitude response.
+
+        Uses the homomorphic method: the real cepstrum of the log magnitude is folded onto
+        positive quefrencies and transformed back, all in double precision with at least
+        64 times padding. Magnitudes are floored at -200 dB relative to the peak, so exact
+        zeros become very deep notches. For the lowpass designs here the pass band stays
+        within 0.001 dB of the original, and the stop band keeps the original's attenuation
+        down to about -115 dB, which is where cepstral aliasing ends up. Most of the energy
+        moves to the first taps, so the delay shrinks from half the length to the filter's
+        group delay in the pass band, typically a few dozen to a few hundred samples.
+        Takes up to a few hundred milliseconds for the longest sets.
+    */
+    static Coefficients::Ptr makeMinimumPhase (const Coefficients& coefficients);
+
+    /** Solves toeplitz (r) * x = b for a symmetric positive definite matrix with first row r.
+        Returns false if the recursion breaks down because the matrix is not positive definite.
+    */
+    static bool solveSymmetricToeplitz (const double* r, const double* b, double* x, int n);
+};
@@ -0,0 +1,301 @@
+#include "InterleavedConvolution.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#elif JUCE_ARM && (defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define FIR_HAS_NEON 1
+#endif
+
+#if JUCE_GCC || JUCE_CLANG
+ #define FIR_TARGET(name) __attribute__ ((target (name)))
+#else
+ #define FIR_TARGET(name)
+#endif
+
+// a fused multiply-add rounds once instead of twice, and the kernels would stop matching the scalar one
+#if JUCE_CLANG
+ #pragma STDC FP_CONTRACT OFF
+#elif JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_MSVC
+ #pragma fp_contract (off)
+#endif
+
+namespace
+{
+    constexpr int numLanes = InterleavedConvolution::numLanes;
+
+    /*  All kernels compute
+            lanes[l] = sum over i = l, l + 16, l + 32, ... of coefficients[i] * history[i]
+        accumulating each lane strictly in order and without fused multiply-adds, so that
+        they agree bit for bit. numFloats is always a multiple of 16, and coefficients is
+        64 byte aligned; history is not.
+    */
+    void dotProductScalar (const float* coefficients, const float* history, int numFloats, float* lanes)
+    {
+        float sums[numLanes] = {};
+
+        for (int i = 0; i < numFloats; i += numLanes)
+        {
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const auto product = coefficients[i + l] * history[i + l];
+                sums[l] = sums[l] + product;
+            }
+        }
+
+        std::copy (sums, sums + numLanes, lanes);
+    }
+
+   #if JUCE_INTEL
+    FIR_TARGET ("sse2")
+    void dotProductSSE2 (const float* coefficients, const float* history, int numFloats, float* lanes)
+    {
+        auto s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+
+        for (int i = 0; i < numFloats; i += numLanes)
+        {
+            s0 = _mm_add_ps (s0, _mm_mul_ps (_mm_load_ps (coefficients + i),      _mm_loadu_ps (history + i)));
+            s1 = _mm_add_ps (s1, _mm_mul_ps (_mm_load_ps (coefficients + i + 4),  _mm_loadu_ps (history + i + 4)));
+            s2 = _mm_add_ps (s2, _mm_mul_ps (_mm_load_ps (coefficients + i + 8),  _mm_loadu_ps (history + i + 8)));
+            s3 = _mm_add_ps (s3, _mm_mul_ps (_mm_load_ps (coefficients + i + 12), _mm_loadu_ps (history + i + 12)));
+        }
+
+        _mm_storeu_ps (lanes,      s0);
+        _mm_storeu_ps (lanes + 4,  s1);
+        _mm_storeu_ps (lanes + 8,  s2);
+        _mm_storeu_ps (lanes + 12, s3);
+    }
+
+    FIR_TARGET ("avx2")
+    void dotProductAVX2 (const float* coefficients, const float* history, int numFloats, float* lanes)
+    {
+        auto s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+
+        for (int i = 0; i < numFloats; i += numLanes)
+        {
+            s0 = _mm256_add_ps (s0, _mm256_mul_ps (_mm256_load_ps (coefficients + i),     _mm256_loadu_ps (history + i)));
+            s1 = _mm256_add_ps (s1, _mm256_mul_ps (_mm256_load_ps (coefficients + i + 8), _mm256_loadu_ps (history + i + 8)));
+        }
+
+        _mm256_storeu_ps (lanes,     s0);
+        _mm256_storeu_ps (lanes + 8, s1);
+    }
+
+    FIR_TARGET ("avx512f")
+    void dotProductAVX512 (const float* coefficients, const float* history, int numFloats, float* lanes)
+    {
+        auto s0 = _mm512_setzero_ps();
+
+        for (int i = 0; i < numFloats; i += numLanes)
+            s0 = _mm512_add_ps (s0, _mm512_mul_ps (_mm512_load_ps (coefficients + i), _mm512_loadu_ps (history + i)));
+
+        _mm512_storeu_ps (lanes, s0);
+    }
+   #endif
+
+   #if FIR_HAS_NEON
+    void dotProductNeon (const float* coefficients, const float* history, int numFloats, float* lanes)
+    {
+        auto s0 = vdupq_n_f32 (0.f), s1 = vdupq_n_f32 (0.f), s2 = vdupq_n_f32 (0.f), s3 = vdupq_n_f32 (0.f);
+
+        // vmulq + vaddq rather than vfmaq, to stay identical to the scalar kernel
+        for (int i = 0; i < numFloats; i += numLanes)
+        {
+            s0 = vaddq_f32 (s0, vmulq_f32 (vld1q_f32 (coefficients + i),      vld1q_f32 (history + i)));
+            s1 = vaddq_f32 (s1, vmulq_f32 (vld1q_f32 (coefficients + i + 4),  vld1q_f32 (history + i + 4)));
+            s2 = vaddq_f32 (s2, vmulq_f32 (vld1q_f32 (coefficients + i + 8),  vld1q_f32 (history + i + 8)));
+            s3 = vaddq_f32 (s3, vmulq_f32 (vld1q_f32 (coefficients + i + 12), vld1q_f32 (history + i + 12)));
+        }
+
+        vst1q_f32 (lanes,      s0);
+        vst1q_f32 (lanes + 4,  s1);
+        vst1q_f32 (lanes + 8,  s2);
+        vst1q_f32 (lanes + 12, s3);
+    }
+   #endif
+}
+
+//==============================================================================
+bool InterleavedConvolution::isSupported (InstructionSet set)
+{
+    switch (set)
+    {
+        case InstructionSet::scalar:  return true;
+       #if JUCE_INTEL
+        case InstructionSet::sse2:    return SystemStats::hasSSE2();
+        case InstructionSet::avx2:    return SystemStats::hasAVX2();
+        case InstructionSet::avx512:  return SystemStats::hasAVX512F();
+       #endif
+       #if FIR_HAS_NEON
+        case InstructionSet::neon:    return true;
+       #endif
+        default:                      return false;
+    }
+}
+
+InterleavedConvolution::Kernel InterleavedConvolution::getKernel (InstructionSet set)
+{
+    switch (set)
+    {
+       #if JUCE_INTEL
+        case InstructionSet::sse2:    return dotProductSSE2;
+        case InstructionSet::avx2:    return dotProductAVX2;
+        case InstructionSet::avx512:  return dotProductAVX512;
+       #endif
+       #if FIR_HAS_NEON
+        case InstructionSet::neon:    return dotProductNeon;
+       #endif
+        default:                      return dotProductScalar;
+    }
+}
+
+InterleavedConvolution::InstructionSet InterleavedConvolution::getBestInstructionSet ()
+{
+    for (auto set : { InstructionSet::avx512, InstructionSet::avx2, InstructionSet::neon, InstructionSet::sse2 })
+        if (isSupported (set))
+            return set;
+
+    return InstructionSet::scalar;
+}
+
+String InterleavedConvolution::getName (InstructionSet set)
+{
+    switch (set)
+    {
+        case InstructionSet::scalar:  return "scalar";
+        case InstructionSet::sse2:    return "SSE2";
+        case InstructionSet::avx2:    return "AVX2";
+        case InstructionSet::avx512:  return "AVX-512";
+        case InstructionSet::neon:    return "NEON";
+    }
+
+    return {};
+}
+
+//==============================================================================
+InterleavedConvolution::InterleavedConvolution ()
+{
+    setInstructionSet (getBestInstructionSet ());
+}
+
+void InterleavedConvolution::setInstructionSet (InstructionSet newInstructionSet)
+{
+    instructionSet = isSupported (newInstructionSet) ? newInstructionSet : InstructionSet::scalar;
+    kernel = getKernel (instructionSet);
+}
+
+void InterleavedConvolution::prepare (const Spec& spec, int maxNumTaps)
+{
+    maxTaps = jmax (1, maxNumTaps);
+
+    // the extra frames make room for the zero padding in front of the oldest tap
+    ringSize = maxTaps + numLanes;
+
+    groups.clear ();
+
+    for (int first = 0; first < (int)spec.numChannels; first += maxGroupSize)
+    {
+        Group group;
+        group.firstChannel = first;
+        group.numChannels = jmin (maxGroupSize, (int)spec.numChannels - first);
+        group.stride = nextPowerOfTwo (group.numChannels);
+        group.history.allocate ((size_t)(2 * ringSize * group.stride));
+
+        groups.push_back (std::move (group));
+    }
+
+    // expanded for the previous channel layout
+    coefficients = nullptr;
+    reset ();
+}
+
+InterleavedConvolution::ExpandedCoefficients::Ptr InterleavedConvolution::createExpandedCoefficients (const Coefficients& newCoefficients) const
+{
+    ExpandedCoefficients::Ptr result = new ExpandedCoefficients ();
+
+    const auto numTaps = jmin ((int)newCoefficients.getFilterSize (), maxTaps);
+    const auto* taps = newCoefficients.getRawCoefficients ();
+
+    for (auto& group : groups)
+    {
+        const auto numUsed = numTaps * group.stride;
+        const auto numFloats = (numUsed + numLanes - 1) / numLanes * numLanes;
+        const auto padding = numFloats - numUsed;
+
+        AlignedBuffer expanded;
+        expanded.allocate ((size_t)jmax (numFloats, numLanes));
+
+        // oldest frame first, so the coefficients are reversed
+        for (int t = 0; t < numTaps; ++t)
+            FloatVectorOperations::fill (expanded + padding + t * group.stride, taps[numTaps - 1 - t], group.stride);
+
+        result->groups.push_back (std::move (expanded));
+        result->numFloats.push_back (numFloats);
+        result->strides.push_back (group.stride);
+    }
+
+    return result;
+}
+
+void InterleavedConvolution::setCoefficients (ExpandedCoefficients::Ptr newCoefficients)
+{
+    // created for a different channel layout, prepare() has been called in between
+    jassert (newCoefficients == nullptr || newCoefficients->groups.size () == groups.size ());
+
+    std::swap (coefficients, newCoefficients);
+}
+
+void InterleavedConvolution::reset ()
+{
+    for (auto& group : groups)
+        FloatVectorOperations::clear (group.history.get (), 2 * ringSize * group.stride);
+
+    writePosition = 0;
+}
+
+void InterleavedConvolution::process (const Context& context)
+{
+    auto& inputBlock = context.getInputBlock ();
+    auto& outputBlock = context.getOutputBlock ();
+
+    const auto numChannels = (int)jmin (inputBlock.getNumChannels (), outputBlock.getNumChannels ());
+    const auto numSamples = (int)inputBlock.getNumSamples ();
+
+    float lanes[numLanes];
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        writePosition = writePosition + 1 == ringSize ? 0 : writePosition + 1;
+
+        for (size_t g = 0; g < groups.size (); ++g)
+        {
+            auto& group = groups[g];
+            const auto stride = group.stride;
+            const auto* expanded = coefficients != nullptr ? coefficients->groups[g].get () : nullptr;
+            const auto numFloats = coefficients != nullptr ? coefficients->numFloats[g] : 0;
+            const auto numGroupChannels = jmin (group.numChannels, numChannels - group.firstChannel);
+
+            auto* frame = group.history + writePosition * stride;
+            auto* mirror = frame + ringSize * stride;
+
+            for (int ch = 0; ch < numGroupChannels; ++ch)
+                frame[ch] = mirror[ch] = inputBlock.getChannelPointer ((size_t)(group.firstChannel + ch))[n];
+
+            // the newest numFloats values end with the frame just written, always in one piece
+            const auto end = (writePosition + ringSize + 1) * stride;
+            kernel (expanded, group.history + end - numFloats, numFloats, lanes);
+
+            for (int ch = 0; ch < numGroupChannels; ++ch)
+            {
+                auto sum = lanes[ch];
+
+                for (int l = ch + stride; l < numLanes; l += stride)
+                    sum += lanes[l];
+
+                outputBlock.getChannelPointer ((size_t)(group.firstChannel + ch))[n] = sum;
+            }
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Direct-form FIR that processes all channels of a sample with one vectorised dot product.
+
+    The input history is stored channel-interleaved (frame after frame, with the channel count
+    padded to a power of two) in a mirrored ring buffer: every frame is written twice, L frames
+    apart, so the last numTaps frames are always one contiguous run of memory. The coefficients
+    are expanded to the same interleaved layout once per design, which turns each output frame
+    into a single element-wise multiply-add over two contiguous arrays with no branches, no
+    modulo and no per-channel loop inside.
+
+    The dot product keeps 16 partial sums regardless of the instruction set, and they are
+    reduced in the same order afterwards. The kernels only match the scalar one bit for bit if
+    no multiply and add are fused, which GCC does by default even to intrinsics; the .cpp turns
+    contraction off for GCC, Clang and MSVC. With any other compiler the kernels may only
+    agree to within rounding.
+
+    The history and the expanded coefficients start on 64 byte boundaries. The coefficients
+    are read with aligned loads, but the history window moves on by one frame per sample, so
+    it is only aligned when the stride is 16 and the kernels read it with unaligned loads.
+*/
+class InterleavedConvolution
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+    using Coefficients = dsp::FIR::Coefficients<SampleType>;
+
+    enum class InstructionSet
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    /** The fastest kernel this CPU supports. */
+    static InstructionSet getBestInstructionSet ();
+    static String getName (InstructionSet instructionSet);
+
+    InterleavedConvolution ();
+
+    void prepare (const Spec& spec, int maxNumTaps);
+
+    /** Forces a particular kernel, e.g. the scalar one as a reference. Unsupported sets fall back to scalar. */
+    void setInstructionSet (InstructionSet newInstructionSet);
+    InstructionSet getInstructionSet () const { return instructionSet; }
+
+    /** Zeroed floats starting on a 64 byte boundary, so that a run of numLanes fills a cache line. */
+    class AlignedBuffer
+    {
+    public:
+        static constexpr size_t alignment = 64;
+
+        void allocate (size_t numFloats)
+        {
+            memory.allocate (numFloats * sizeof (float) + alignment, true);
+            data = reinterpret_cast<float*> ((reinterpret_cast<uintptr_t> (memory.get ()) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        }
+
+        float* get () const { return data; }
+        operator float* () const { return data; }
+
+    private:
+        HeapBlock<char> memory;
+        float* data = nullptr;
+    };
+
+    /** A coefficient set expanded to the interleaved layout of every channel group. */
+    struct ExpandedCoefficients : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<ExpandedCoefficients>;
+
+        std::vector<AlignedBuffer> groups;     // numFloats[g] floats per group, oldest frame first
+        std::vector<int> numFloats;
+        std::vector<int> strides;
+    };
+
+    /** Expands coefficients for the channel groups chosen in prepare().
+        Allocates, so call it from the thread designing the coefficients.
+    */
+    ExpandedCoefficients::Ptr createExpandedCoefficients (const Coefficients& coefficients) const;
+
+    /** Swaps in a set created by createExpandedCoefficients(), or silences the filter when passed
+        nullptr. Only exchanges a reference, call from the audio thread.
+    */
+    void setCoefficients (ExpandedCoefficients::Ptr newCoefficients);
+
+    void reset ();
+    void process (const Context& context);
+
+    /** Number of partial sums every kernel keeps, and the granularity of the padded coefficients. */
+    static constexpr int numLanes = 16;
+
+    /** Channels are processed in groups of at most this many. */
+    static constexpr int maxGroupSize = numLanes;
+
+    using Kernel = void (*) (const float* coefficients, const float* history, int numFloats, float* lanes);
+
+private:
+    struct Group
+    {
+        int firstChannel = 0;
+        int numChannels = 0;
+        int stride = 0;                         // numChannels rounded up to a power of two
+        AlignedBuffer history;                  // 2 * ringSize frames of stride floats
+    };
+
+    static bool isSupported (InstructionSet instructionSet);
+    static Kernel getKernel (InstructionSet instructionSet);
+
+    std::vector<Group> groups;
+    ExpandedCoefficients::Ptr coefficients;
+
+    InstructionSet instructionSet = InstructionSet::scalar;
+    Kernel kernel = nullptr;
+
+    int ringSize = 0;
+    int maxTaps = 0;
+    int writePosition = 0;
+};
@@ -0,0 +1,69 @@
+#include "KernelStore.h"
+
+KernelStore::KernelStore (int kernels, int maxNumTaps, int size, int numChannels)
+    : numKernels (kernels),
+      partitionSize (size),
+      numBins (size + 1),
+      maxNumPartitions (jmax (1, (maxNumTaps + size - 1) / size)),
+      kernelPartitions ((size_t)kernels, 0),
+      channelKernels ((size_t)numChannels, -1)
+{
+    jassert (isPowerOfTwo (partitionSize));
+
+    constexpr size_t alignment = 64;
+    const auto numFloats = (size_t)numKernels * (size_t)maxNumPartitions * 2 * (size_t)numBins;
+
+    memory.allocate (numFloats * sizeof (float) + alignment, true);
+    arena = reinterpret_cast<float*> ((reinterpret_cast<uintptr_t> (memory.get ()) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void KernelStore::setKernel (int index, const float* impulseResponse, int numTaps)
+{
+    jassert (isPositiveAndBelow (index, numKernels));
+
+    numTaps = jmin (numTaps, maxNumPartitions * partitionSize);
+
+    const auto fftSize = 2 * partitionSize;
+    dsp::FFT fft (roundToInt (std::log2 (fftSize)));
+    HeapBlock<float> buffer ((size_t)fftSize * 2, true);
+
+    const auto numPartitions = jmax (1, (numTaps + partitionSize - 1) / partitionSize);
+    kernelPartitions[(size_t)index] = numPartitions;
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto offset = p * partitionSize;
+
+        FloatVectorOperations::clear (buffer.get (), fftSize * 2);
+        FloatVectorOperations::copy (buffer.get (), impulseResponse + offset, jmax (0, jmin (partitionSize, numTaps - offset)));
+
+        fft.performRealOnlyForwardTransform (buffer.get (), true);
+
+        auto* re = const_cast<float*> (getReal (index, p));
+        auto* im = const_cast<float*> (getImag (index, p));
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            re[k] = buffer[2 * k];
+            im[k] = buffer[2 * k + 1];
+        }
+    }
+}
+
+void KernelStore::copyKernel (int index, const KernelStore& source, int sourceIndex)
+{
+    jassert (source.partitionSize == partitionSize);
+
+    const auto numPartitions = jmin (source.getNumPartitions (sourceIndex), maxNumPartitions);
+    kernelPartitions[(size_t)index] = numPartitions;
+
+    FloatVectorOperations::copy (const_cast<float*> (getReal (index, 0)), source.getReal (sourceIndex, 0), numPartitions * 2 * numBins);
+}
+
+void KernelStore::setChannelKernel (int channel, int kernel)
+{
+    jassert (kernel < numKernels);
+
+    if (isPositiveAndBelow (channel, (int)channelKernels.size ()))
+        channelKernels[(size_t)channel] = kernel;
+}
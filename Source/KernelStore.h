@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** The partition spectra of several impulse responses, plus which channel uses which.
+
+    All kernels live in one contiguous, 64 byte aligned arena, laid out kernel by kernel
+    and partition by partition with the same split real / imaginary format as
+    PartitionedImpulseResponse, so a UniformPartitionedConvolution can give every channel
+    its own kernel without any per-channel allocations. Channels may share a kernel.
+
+    A store is built completely off the audio thread and never changed once handed over.
+    Replacing some kernels means building a new store: copyKernel() carries the unchanged
+    spectra over without transforming them again, and the whole store is then swapped in
+    one step, so the audio thread never sees a partial update.
+*/
+struct KernelStore : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<KernelStore>;
+
+    KernelStore (int numKernels, int maxNumTaps, int partitionSize, int numChannels);
+
+    /** Transforms an impulse response of up to maxNumTaps into kernel index. */
+    void setKernel (int index, const float* impulseResponse, int numTaps);
+
+    /** Copies an already transformed kernel from a store with the same partition size. */
+    void copyKernel (int index, const KernelStore& source, int sourceIndex);
+
+    /** Selects the kernel a channel runs through, -1 silences it. */
+    void setChannelKernel (int channel, int kernel);
+
+    int getChannelKernel (int channel) const { return isPositiveAndBelow (channel, (int)channelKernels.size ()) ? channelKernels[(size_t)channel] : -1; }
+    int getNumPartitions (int kernel) const { return kernelPartitions[(size_t)kernel]; }
+
+    const float* getReal (int kernel, int partition) const { return arena + ((size_t)kernel * (size_t)maxNumPartitions + (size_t)partition) * 2 * (size_t)numBins; }
+    const float* getImag (int kernel, int partition) const { return getReal (kernel, partition) + numBins; }
+
+    int numKernels;
+    int partitionSize;
+    int numBins;
+    int maxNumPartitions;
+
+private:
+    HeapBlock<char> memory;
+    float* arena = nullptr;
+
+    std::vector<int> kernelPartitions;
+    std::vector<int> channelKernels;
+};
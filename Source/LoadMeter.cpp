@@ -0,0 +1,242 @@
+#include "LoadMeter.h"
+
+LoadMeter::LoadMeter ()
+{
+    ticksToMicroseconds = 1.0e6 / (double)Time::getHighResolutionTicksPerSecond ();
+    clear ();
+}
+
+void LoadMeter::prepare (double sampleRate)
+{
+    samplePeriodMicroseconds = sampleRate > 0.0 ? 1.0e6 / sampleRate : 0.0;
+    resetRequested = false;
+    clear ();
+}
+
+//==============================================================================
+LoadMeter::ScopedBlock::ScopedBlock (LoadMeter& meter, int n, bool isActive) noexcept
+    : owner (meter), numSamples (n), active (isActive), start (isActive ? Time::getHighResolutionTicks () : 0)
+{
+}
+
+LoadMeter::ScopedBlock::~ScopedBlock ()
+{
+    if (active)
+        owner.addBlock (numSamples, Time::getHighResolutionTicks () - start, swapTicks);
+}
+
+void LoadMeter::ScopedBlock::swapFinished () noexcept
+{
+    if (active)
+        swapTicks = Time::getHighResolutionTicks () - start;
+}
+
+//==============================================================================
+template <int numBuckets>
+void LoadMeter::Histogram<numBuckets>::clear () noexcept
+{
+    for (auto& count : counts)
+        count.store (0, std::memory_order_relaxed);
+}
+
+template <int numBuckets>
+void LoadMeter::Histogram<numBuckets>::add (int bucket) noexcept
+{
+    // only the audio thread writes, so a load and a store do instead of a locked increment
+    auto& count = counts[(size_t)jlimit (0, numBuckets, bucket)];
+    count.store (count.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+template <int numBuckets>
+std::vector<int64> LoadMeter::Histogram<numBuckets>::read () const
+{
+    std::vector<int64> result;
+    result.reserve (counts.size ());
+
+    for (auto& count : counts)
+        result.push_back (count.load (std::memory_order_relaxed));
+
+    return result;
+}
+
+//==============================================================================
+int LoadMeter::getTimeBucket (double microseconds) noexcept
+{
+    return microseconds <= 1.0 ? 0 : (int)std::ceil (std::log2 (microseconds) * timeBucketsPerOctave);
+}
+
+double LoadMeter::getTimeBucketEdge (int bucket)
+{
+    return std::exp2 ((double)bucket / timeBucketsPerOctave);
+}
+
+void LoadMeter::addBlock (int numSamples, int64 blockTicks, int64 swapTicks) noexcept
+{
+    if (resetRequested.load (std::memory_order_relaxed) && resetRequested.exchange (false))
+        clear ();
+
+    const auto increment = [] (std::atomic<int64>& counter) { counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed); };
+    const auto accumulate = [] (std::atomic<double>& sum, std::atomic<double>& max, double value)
+    {
+        sum.store (sum.load (std::memory_order_relaxed) + value, std::memory_order_relaxed);
+
+        if (value > max.load (std::memory_order_relaxed))
+            max.store (value, std::memory_order_relaxed);
+    };
+
+    const auto microseconds = (double)blockTicks * ticksToMicroseconds;
+    const auto budget = numSamples * samplePeriodMicroseconds.load (std::memory_order_relaxed);
+    const auto load = budget > 0.0 ? microseconds / budget : 0.0;
+
+    increment (numBlocks);
+
+    if (load > 1.0)
+        increment (numOverruns);
+
+    accumulate (loadSum, maxLoad, load);
+    accumulate (microsecondSum, maxMicroseconds, microseconds);
+    loadHistogram.add ((int)std::ceil (load * loadBucketsPerUnit));
+    microsecondHistogram.add (getTimeBucket (microseconds));
+
+    if (swapTicks >= 0)
+    {
+        const auto swapMicroseconds = (double)swapTicks * ticksToMicroseconds;
+
+        increment (numSwaps);
+        accumulate (swapMicrosecondSum, maxSwapMicroseconds, swapMicroseconds);
+        swapMicrosecondHistogram.add (getTimeBucket (swapMicroseconds));
+    }
+}
+
+void LoadMeter::clear () noexcept
+{
+    for (auto* counter : { &numBlocks, &numOverruns, &numSwaps })
+        counter->store (0, std::memory_order_relaxed);
+
+    for (auto* value : { &loadSum, &maxLoad, &microsecondSum, &maxMicroseconds, &swapMicrosecondSum, &maxSwapMicroseconds })
+        value->store (0.0, std::memory_order_relaxed);
+
+    loadHistogram.clear ();
+    microsecondHistogram.clear ();
+    swapMicrosecondHistogram.clear ();
+}
+
+//==============================================================================
+const std::vector<double>& LoadMeter::getPercentiles ()
+{
+    static const std::vector<double> percentiles { 50.0, 90.0, 99.0, 99.9 };
+    return percentiles;
+}
+
+String LoadMeter::getPercentileName (size_t index)
+{
+    const auto percentile = getPercentiles ()[index];
+    return "p" + String (percentile, percentile == std::floor (percentile) ? 0 : 1);
+}
+
+LoadMeter::Snapshot LoadMeter::getSnapshot () const
+{
+    Snapshot s;
+    s.numBlocks = numBlocks.load (std::memory_order_relaxed);
+    s.numOverruns = numOverruns.load (std::memory_order_relaxed);
+    s.numSwaps = numSwaps.load (std::memory_order_relaxed);
+
+    if (s.numBlocks > 0)
+    {
+        s.meanLoad = loadSum.load (std::memory_order_relaxed) / (double)s.numBlocks;
+        s.meanMicroseconds = microsecondSum.load (std::memory_order_relaxed) / (double)s.numBlocks;
+    }
+
+    if (s.numSwaps > 0)
+        s.meanSwapMicroseconds = swapMicrosecondSum.load (std::memory_order_relaxed) / (double)s.numSwaps;
+
+    s.maxLoad = maxLoad.load (std::memory_order_relaxed);
+    s.maxMicroseconds = maxMicroseconds.load (std::memory_order_relaxed);
+    s.maxSwapMicroseconds = maxSwapMicroseconds.load (std::memory_order_relaxed);
+
+    // the counts are summed again here, so that the percentiles agree with the buckets read
+    const auto summarise = [] (const std::vector<int64>& counts, auto getEdge, std::vector<std::pair<double, int64>>& histogram, std::vector<double>* percentiles)
+    {
+        int64 total = 0;
+
+        for (size_t bucket = 0; bucket < counts.size (); ++bucket)
+        {
+            if (counts[bucket] > 0)
+                histogram.emplace_back (getEdge ((int)bucket), counts[bucket]);
+
+            total += counts[bucket];
+        }
+
+        if (percentiles == nullptr || total == 0)
+            return;
+
+        for (auto percentile : getPercentiles ())
+        {
+            const auto rank = (int64)std::ceil (percentile / 100.0 * (double)total);
+            int64 seen = 0;
+
+            for (auto& [edge, count] : histogram)
+            {
+                if ((seen += count) >= rank)
+                {
+                    percentiles->push_back (edge);
+                    break;
+                }
+            }
+        }
+    };
+
+    const auto loadEdge = [] (int bucket) { return (double)bucket / loadBucketsPerUnit; };
+
+    summarise (loadHistogram.read (), loadEdge, s.loadHistogram, &s.loadPercentiles);
+    summarise (microsecondHistogram.read (), getTimeBucketEdge, s.microsecondHistogram, &s.microsecondPercentiles);
+    summarise (swapMicrosecondHistogram.read (), getTimeBucketEdge, s.swapMicrosecondHistogram, nullptr);
+
+    return s;
+}
+
+bool LoadMeter::writeTo (const File& file) const
+{
+    const auto s = getSnapshot ();
+
+    const auto toVar = [] (const std::vector<std::pair<double, int64>>& histogram)
+    {
+        Array<var> buckets;
+
+        for (auto& [edge, count] : histogram)
+            buckets.add (Array<var> { var (edge), var (count) });
+
+        return var (buckets);
+    };
+
+    const auto percentilesToVar = [] (const std::vector<double>& values)
+    {
+        DynamicObject::Ptr result = new DynamicObject ();
+
+        for (size_t i = 0; i < values.size (); ++i)
+            result->setProperty (getPercentileName (i), values[i]);
+
+        return var (result.get ());
+    };
+
+    DynamicObject::Ptr report = new DynamicObject ();
+    report->setProperty ("date", Time::getCurrentTime ().toISO8601 (true));
+    report->setProperty ("numBlocks", s.numBlocks);
+    report->setProperty ("numOverruns", s.numOverruns);
+    report->setProperty ("numSwaps", s.numSwaps);
+    report->setProperty ("meanLoad", s.meanLoad);
+    report->setProperty ("maxLoad", s.maxLoad);
+    report->setProperty ("loadPercentiles", percentilesToVar (s.loadPercentiles));
+    report->setProperty ("meanMicroseconds", s.meanMicroseconds);
+    report->setProperty ("maxMicroseconds", s.maxMicroseconds);
+    report->setProperty ("microsecondPercentiles", percentilesToVar (s.microsecondPercentiles));
+    report->setProperty ("meanSwapMicroseconds", s.meanSwapMicroseconds);
+    report->setProperty ("maxSwapMicroseconds", s.maxSwapMicroseconds);
+
+    // [upper edge, count] per non-empty bucket
+    report->setProperty ("loadHistogram", toVar (s.loadHistogram));
+    report->setProperty ("microsecondHistogram", toVar (s.microsecondHistogram));
+    report->setProperty ("swapMicrosecondHistogram", toVar (s.swapMicrosecondHistogram));
+
+    return file.replaceWithText (JSON::toString (var (report.get ())) + "\n");
+}
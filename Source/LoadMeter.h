@@ -0,0 +1,120 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Measures how much of each block's deadline FirFilter::process uses.
+
+    The audio thread times every block with a ScopedBlock and only updates relaxed atomics:
+    a few counters, two running maxima and one bucket of each histogram, so a block costs
+    two clock reads, three with a swap, and no allocation or lock. Any other thread can take a
+    Snapshot at any time; as nothing stops the audio thread meanwhile, its fields may be
+    one block apart from each other.
+
+    The deadline of a block is its duration, numSamples / sampleRate. Load histograms hold
+    the block time relative to it in steps of half a percent up to 200%; the time
+    histograms have eight buckets per octave from 1 us up to about a second. Offline
+    renders have no deadline and are not measured.
+*/
+class LoadMeter
+{
+public:
+    LoadMeter ();
+
+    /** Called while the audio thread is stopped. Clears everything measured so far. */
+    void prepare (double sampleRate);
+
+    /** Times one block, from its construction to its destruction. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (LoadMeter& meter, int numSamples, bool isActive) noexcept;
+        ~ScopedBlock ();
+
+        /** Marks the end of a coefficient swap done at the start of the block. */
+        void swapFinished () noexcept;
+
+    private:
+        LoadMeter& owner;
+        const int numSamples;
+        const bool active;
+        const int64 start;
+        int64 swapTicks = -1;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    struct Snapshot
+    {
+        int64 numBlocks = 0;
+        int64 numOverruns = 0;      // blocks that took longer than they last
+        int64 numSwaps = 0;
+
+        double meanLoad = 0.0;      // relative to the block duration, 1 is the deadline
+        double maxLoad = 0.0;
+        double meanMicroseconds = 0.0;
+        double maxMicroseconds = 0.0;
+        double meanSwapMicroseconds = 0.0;
+        double maxSwapMicroseconds = 0.0;
+
+        /** Upper bucket edges at the percentiles listed in getPercentiles(). */
+        std::vector<double> loadPercentiles;
+        std::vector<double> microsecondPercentiles;
+
+        /** Non-empty buckets as (upper edge, count) pairs. */
+        std::vector<std::pair<double, int64>> loadHistogram;
+        std::vector<std::pair<double, int64>> microsecondHistogram;
+        std::vector<std::pair<double, int64>> swapMicrosecondHistogram;
+    };
+
+    /** Any thread. */
+    Snapshot getSnapshot () const;
+
+    /** Any thread: the audio thread clears the measurements at its next block. */
+    void reset () noexcept { resetRequested = true; }
+
+    /** Any thread but the audio thread: writes the snapshot as JSON. */
+    bool writeTo (const File& file) const;
+
+    static const std::vector<double>& getPercentiles ();
+
+    /** "p50", "p99.9" and so on, for the percentile at index. */
+    static String getPercentileName (size_t index);
+
+private:
+    static constexpr int numLoadBuckets = 400;
+    static constexpr int loadBucketsPerUnit = 200;
+    static constexpr int numTimeBuckets = 160;
+    static constexpr int timeBucketsPerOctave = 8;
+
+    template <int numBuckets>
+    struct Histogram
+    {
+        std::array<std::atomic<int64>, numBuckets + 1> counts;  // the last one collects everything above
+
+        void clear () noexcept;
+        void add (int bucket) noexcept;
+        std::vector<int64> read () const;
+    };
+
+    static int getTimeBucket (double microseconds) noexcept;
+    static double getTimeBucketEdge (int bucket);
+
+    void addBlock (int numSamples, int64 blockTicks, int64 swapTicks) noexcept;
+    void clear () noexcept;
+
+    double ticksToMicroseconds = 0.0;
+    std::atomic<double> samplePeriodMicroseconds { 0.0 };
+
+    std::atomic<int64> numBlocks { 0 }, numOverruns { 0 }, numSwaps { 0 };
+    std::atomic<double> loadSum { 0.0 }, maxLoad { 0.0 };
+    std::atomic<double> microsecondSum { 0.0 }, maxMicroseconds { 0.0 };
+    std::atomic<double> swapMicrosecondSum { 0.0 }, maxSwapMicroseconds { 0.0 };
+
+    Histogram<numLoadBuckets> loadHistogram;
+    Histogram<numTimeBuckets> microsecondHistogram;
+    Histogram<numTimeBuckets> swapMicrosecondHistogram;
+
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE (LoadMeter)
+};
@@ -0,0 +1,334 @@
+#include "NonUniformConvolution.h"
+
+NonUniformPartitionedConvolution::NonUniformPartitionedConvolution ()
+{
+    head.state = new Coefficients ((size_t)headSize);
+}
+
+NonUniformPartitionedConvolution::~NonUniformPartitionedConvolution ()
+{
+    worker.stopThread (1000);
+}
+
+void NonUniformPartitionedConvolution::prepare (const Spec& spec, int maxNumTaps)
+{
+    worker.stopThread (1000);
+
+    numChannels = (int)spec.numChannels;
+    head.prepare (spec);
+    inputCopy.setSize (numChannels, (int)spec.maximumBlockSize);
+
+    segments.clear ();
+
+    auto addSegment = [&] (int partitionSize, int offset, int numTaps)
+    {
+        auto segment = std::make_unique<Segment> ();
+        segment->partitionSize = partitionSize;
+        segment->offset = offset;
+        segment->numTaps = numTaps;
+        segment->runsInBackground = offset >= 2 * partitionSize && partitionSize >= 2 * (int)spec.maximumBlockSize;
+
+        // a background segment delivers one partition later than a synchronous one
+        const auto delay = offset / partitionSize - (segment->runsInBackground ? 2 : 1);
+        segment->engine.prepare (spec, partitionSize, numTaps, delay);
+
+        for (auto* buffers : { &segment->frame, &segment->output, &segment->jobInput, &segment->jobOutput, &segment->missedFrame })
+        {
+            buffers->resize ((size_t)numChannels);
+
+            for (auto& buffer : *buffers)
+                buffer.allocate ((size_t)partitionSize, true);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            segment->framePointers.push_back (segment->frame[(size_t)ch].get ());
+            segment->outputPointers.push_back (segment->output[(size_t)ch].get ());
+            segment->jobInputPointers.push_back (segment->jobInput[(size_t)ch].get ());
+            segment->jobOutputPointers.push_back (segment->jobOutput[(size_t)ch].get ());
+            segment->missedFramePointers.push_back (segment->missedFrame[(size_t)ch].get ());
+        }
+
+        segments.push_back (std::move (segment));
+    };
+
+    if (maxNumTaps > headSize)
+        addSegment (headSize, headSize, jmin (3 * headSize, maxNumTaps - headSize));
+
+    for (int partitionSize = 2 * headSize, offset = 4 * headSize; offset < maxNumTaps; partitionSize *= 2)
+    {
+        const auto end = partitionSize == maxPartitionSize ? maxNumTaps : jmin (2 * offset, maxNumTaps);
+        addSegment (partitionSize, offset, end - offset);
+        offset = end;
+    }
+
+    // most hosts never pick this mode, so the worker waits for startWorker()
+    reset ();
+}
+
+void NonUniformPartitionedConvolution::startWorker ()
+{
+    const auto needsWorker = std::any_of (segments.begin (), segments.end (), [] (auto& s) { return s->runsInBackground; });
+
+    if (needsWorker && ! worker.isThreadRunning ())
+        worker.startThread (Thread::Priority::high);
+}
+
+NonUniformPartitionedConvolution::Layout NonUniformPartitionedConvolution::getLayout () const
+{
+    Layout layout;
+
+    for (auto& segment : segments)
+        layout.segments.push_back ({ segment->partitionSize, segment->offset, segment->numTaps });
+
+    return layout;
+}
+
+NonUniformImpulseResponse::Ptr NonUniformPartitionedConvolution::createImpulseResponse (const Layout& layout, const SampleType* impulseResponse, int numTaps)
+{
+    NonUniformImpulseResponse::Ptr result = new NonUniformImpulseResponse ();
+
+    result->head = new Coefficients ((size_t)headSize);
+    FloatVectorOperations::copy (result->head->getRawCoefficients (), impulseResponse, jmin (numTaps, headSize));
+
+    for (auto& segment : layout.segments)
+    {
+        const auto numSegmentTaps = jmin (numTaps - segment.offset, segment.numTaps);
+
+        if (numSegmentTaps > 0)
+            result->segments.push_back (new PartitionedImpulseResponse (impulseResponse + segment.offset, numSegmentTaps, segment.partitionSize));
+        else
+            result->segments.push_back (nullptr);
+    }
+
+    return result;
+}
+
+void NonUniformPartitionedConvolution::setImpulseResponse (NonUniformImpulseResponse::Ptr newImpulseResponse)
+{
+    if (newImpulseResponse != nullptr && newImpulseResponse->segments.size () != segments.size ())
+    {
+        jassertfalse; // created for a different layout, prepare() has been called in between
+        return;
+    }
+
+    // the background segments would never be computed, and an offline render would wait for them forever
+    jassert (newImpulseResponse == nullptr || worker.isThreadRunning () || std::none_of (segments.begin (), segments.end (), [] (auto& s) { return s->runsInBackground; }));
+
+    if (newImpulseResponse != nullptr)
+        FloatVectorOperations::copy (head.state->getRawCoefficients (), newImpulseResponse->head->getRawCoefficients (), headSize);
+    else
+        FloatVectorOperations::clear (head.state->getRawCoefficients (), headSize);
+
+    for (size_t i = 0; i < segments.size (); ++i)
+    {
+        auto& segment = *segments[i];
+        auto segmentResponse = newImpulseResponse != nullptr ? newImpulseResponse->segments[i] : nullptr;
+
+        if (segment.runsInBackground)
+        {
+            // the worker may be busy with this segment, so the swap waits for its next frame
+            segment.nextImpulseResponse = segmentResponse;
+            segment.hasNextImpulseResponse = true;
+            continue;
+        }
+
+        if (! segment.isActive)
+            segment.engine.reset ();
+
+        segment.isActive = segmentResponse != nullptr;
+        segment.engine.setImpulseResponse (segmentResponse);
+    }
+}
+
+void NonUniformPartitionedConvolution::reset ()
+{
+    head.reset ();
+
+    for (auto& segment : segments)
+    {
+        // called from the audio thread on a mode change, so a busy worker keeps the engine and
+        // its job buffers, and the segment starts over once it hands them back
+        segment->needsReset = segment->jobState.load () == pending;
+        segment->numMissedFrames = 0;
+
+        if (! segment->needsReset)
+        {
+            segment->jobState = idle;
+            segment->engine.reset ();
+
+            for (auto* buffers : { &segment->jobInput, &segment->jobOutput })
+                for (auto& buffer : *buffers)
+                    buffer.clear ((size_t)segment->partitionSize);
+        }
+
+        for (auto* buffers : { &segment->frame, &segment->output })
+            for (auto& buffer : *buffers)
+                buffer.clear ((size_t)segment->partitionSize);
+    }
+
+    samplePosition = 0;
+}
+
+void NonUniformPartitionedConvolution::process (const Context& context)
+{
+    auto& inputBlock = context.getInputBlock ();
+    auto& outputBlock = context.getOutputBlock ();
+
+    const auto numSamples = inputBlock.getNumSamples ();
+    const auto maxChunkSize = (size_t)inputCopy.getNumSamples ();
+    const auto numToProcess = jmin (outputBlock.getNumChannels (), (size_t)numChannels);
+
+    for (size_t start = 0; start < numSamples; start += maxChunkSize)
+    {
+        const auto numThisTime = jmin (maxChunkSize, numSamples - start);
+
+        auto input = inputBlock.getSubsetChannelBlock (0, numToProcess).getSubBlock (start, numThisTime);
+        auto output = outputBlock.getSubsetChannelBlock (0, numToProcess).getSubBlock (start, numThisTime);
+        auto copy = dsp::AudioBlock<SampleType> (inputCopy).getSubsetChannelBlock (0, numToProcess).getSubBlock (0, numThisTime);
+
+        copy.copyFrom (input);
+        output.copyFrom (input);
+        head.process (dsp::ProcessContextReplacing<SampleType> (output));
+
+        for (auto& segment : segments)
+            processSegment (*segment, copy, output);
+
+        samplePosition += (int64)numThisTime;
+    }
+}
+
+void NonUniformPartitionedConvolution::processSegment (Segment& segment, const dsp::AudioBlock<SampleType>& input, const dsp::AudioBlock<SampleType>& output)
+{
+    const auto partitionSize = segment.partitionSize;
+    const auto numSamples = (int)input.getNumSamples ();
+
+    auto position = (int)(samplePosition % partitionSize);
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        const auto numThisTime = jmin (numSamples - done, partitionSize - position);
+
+        for (size_t ch = 0; ch < input.getNumChannels (); ++ch)
+        {
+            FloatVectorOperations::copy (segment.frame[ch] + position, input.getChannelPointer (ch) + done, numThisTime);
+            FloatVectorOperations::add (output.getChannelPointer (ch) + done, segment.output[ch] + position, numThisTime);
+        }
+
+        position += numThisTime;
+        done += numThisTime;
+
+        if (position == partitionSize)
+        {
+            finishFrame (segment);
+            position = 0;
+        }
+    }
+}
+
+void NonUniformPartitionedConvolution::finishFrame (Segment& segment)
+{
+    if (! segment.runsInBackground)
+    {
+        if (segment.isActive)
+            segment.engine.processFrames (segment.framePointers.data (), segment.outputPointers.data ());
+        else
+            for (auto& buffer : segment.output)
+                buffer.clear ((size_t)segment.partitionSize);
+
+        return;
+    }
+
+    if (nonRealtime)
+        while (segment.jobState.load () == pending)
+            Thread::yield ();
+
+    // the frame posted one partition ago is due now; if the worker is still on it, this
+    // partition stays silent and the frame is kept until the worker can take it
+    if (segment.jobState.load () == pending)
+    {
+        ++deadlineMisses;
+
+        if (segment.numMissedFrames++ == 0)
+            for (int ch = 0; ch < numChannels; ++ch)
+                FloatVectorOperations::copy (segment.missedFrame[(size_t)ch].get (), segment.frame[(size_t)ch].get (), segment.partitionSize);
+
+        for (auto& buffer : segment.output)
+            buffer.clear ((size_t)segment.partitionSize);
+
+        return;
+    }
+
+    // a result that arrives after a miss belongs to a partition that has already been played
+    const auto isOnTime = segment.jobState.load () == done && segment.numMissedFrames == 0 && ! segment.needsReset;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (isOnTime)
+            FloatVectorOperations::copy (segment.output[(size_t)ch].get (), segment.jobOutput[(size_t)ch].get (), segment.partitionSize);
+        else
+            segment.output[(size_t)ch].clear ((size_t)segment.partitionSize);
+    }
+
+    segment.jobState = idle;
+
+    // a single missed frame is replayed ahead of this one; after more the history has a gap anyway
+    if (segment.needsReset || segment.numMissedFrames > 1)
+        segment.engine.reset ();
+
+    const auto replayMissedFrame = segment.numMissedFrames == 1;
+    segment.numMissedFrames = 0;
+    segment.needsReset = false;
+
+    if (segment.hasNextImpulseResponse)
+    {
+        if (! segment.isActive)
+            segment.engine.reset ();
+
+        segment.isActive = segment.nextImpulseResponse != nullptr;
+        segment.engine.setImpulseResponse (segment.nextImpulseResponse);
+        segment.nextImpulseResponse = nullptr;
+        segment.hasNextImpulseResponse = false;
+    }
+
+    if (! segment.isActive)
+        return;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        FloatVectorOperations::copy (segment.jobInput[(size_t)ch].get (), segment.frame[(size_t)ch].get (), segment.partitionSize);
+
+    segment.replayMissedFrame = replayMissedFrame;
+    segment.jobState = pending;
+    worker.notify ();
+}
+
+void NonUniformPartitionedConvolution::runJob (Segment& segment)
+{
+    // the missed frame only extends the history, its output was due long ago
+    if (segment.replayMissedFrame)
+        segment.engine.processFrames (segment.missedFramePointers.data (), segment.jobOutputPointers.data ());
+
+    segment.engine.processFrames (segment.jobInputPointers.data (), segment.jobOutputPointers.data ());
+    segment.jobState = done;
+}
+
+//==============================================================================
+void NonUniformPartitionedConvolution::Worker::run ()
+{
+    while (! threadShouldExit ())
+    {
+        // segments are ordered by partition size, so the first pending one is the most urgent
+        for (;;)
+        {
+            auto it = std::find_if (owner.segments.begin (), owner.segments.end (), [] (auto& s) { return s->jobState.load () == pending; });
+
+            if (it == owner.segments.end ())
+                break;
+
+            owner.runJob (**it);
+        }
+
+        wait (-1);
+    }
+}
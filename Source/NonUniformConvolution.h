@@ -0,0 +1,161 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolution.h"
+
+/** Everything a NonUniformPartitionedConvolution needs for one coefficient set:
+    the direct-form head plus the partition spectra of every FFT segment.
+*/
+struct NonUniformImpulseResponse : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<NonUniformImpulseResponse>;
+
+    dsp::FIR::Coefficients<float>::Ptr head;
+    std::vector<PartitionedImpulseResponse::Ptr> segments;
+};
+
+/** Zero latency convolution for long impulse responses.
+
+    The first headSize taps run through the time-domain dsp::FIR::Filter. The rest of the
+    response is cut into segments whose partition size doubles each time, each one starting
+    late enough that its output can be computed before it is needed:
+
+        head     [0, H)         direct form
+        segment  [H, 4H)        partitions of H, computed on the audio thread
+        segment  [2P, 4P)       partitions of P = 2H, 4H, ... up to maxPartitionSize
+        segment  [2P, numTaps)  last segment, as many partitions of maxPartitionSize as needed
+
+    Every segment starting at 2P has a whole partition of slack, so once P is comfortably
+    larger than the host block it is handed to a background thread when its input frame is
+    complete and collected again one partition later. If the worker has not finished by then
+    a deadline miss is counted and the segment stays silent for that partition; the audio
+    thread never waits for the worker. The missed frame is replayed before the next one, so
+    the segment's history stays whole, and after more than one miss in a row the segment
+    starts again from silence. Offline renders have no deadline, so with setNonRealtime()
+    the audio thread does wait and the output stays exact.
+*/
+class NonUniformPartitionedConvolution
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+    using Coefficients = dsp::FIR::Coefficients<SampleType>;
+
+    NonUniformPartitionedConvolution ();
+    ~NonUniformPartitionedConvolution ();
+
+    /** Chooses the segments and stops the worker, which is only started again by startWorker(). */
+    void prepare (const Spec& spec, int maxNumTaps);
+
+    /** Starts the background thread if the layout has segments for it and it isn't running yet.
+        Call it off the audio thread, after prepare() and before the first response is set.
+    */
+    void startWorker ();
+
+    /** The segments prepare() chose. It is all createImpulseResponse() needs, so a designing
+        thread can copy it and run the transforms without holding on to the engine.
+    */
+    struct Layout
+    {
+        struct Segment
+        {
+            int partitionSize = 0;
+            int offset = 0;
+            int numTaps = 0;
+        };
+
+        std::vector<Segment> segments;
+    };
+
+    Layout getLayout () const;
+
+    /** Splits an impulse response into the head and the segments of a layout.
+        Allocates and runs FFTs, so call it from the thread designing the coefficients.
+    */
+    static NonUniformImpulseResponse::Ptr createImpulseResponse (const Layout& layout, const SampleType* impulseResponse, int numTaps);
+
+    /** The same for the layout chosen in prepare(). */
+    NonUniformImpulseResponse::Ptr createImpulseResponse (const SampleType* impulseResponse, int numTaps) const
+    {
+        return createImpulseResponse (getLayout (), impulseResponse, numTaps);
+    }
+
+    /** Swaps in a response created by createImpulseResponse(), or silences the engine when
+        passed nullptr. Call from the audio thread; it only exchanges references.
+    */
+    void setImpulseResponse (NonUniformImpulseResponse::Ptr newImpulseResponse);
+
+    void reset ();
+    void process (const Context& context);
+
+    /** Waits for a late worker instead of dropping its partition. Call from the audio thread. */
+    void setNonRealtime (bool isNonRealtime) { nonRealtime = isNonRealtime; }
+
+    int getLatencyInSamples () const { return 0; }
+    int getNumDeadlineMisses () const { return deadlineMisses.load (); }
+
+    static constexpr int headSize = 64;
+    static constexpr int maxPartitionSize = 4096;
+
+private:
+    enum JobState
+    {
+        idle,
+        pending,
+        done
+    };
+
+    struct Segment
+    {
+        int partitionSize = 0;
+        int offset = 0;
+        int numTaps = 0;
+        bool runsInBackground = false;
+
+        UniformPartitionedConvolution engine;
+        PartitionedImpulseResponse::Ptr nextImpulseResponse;
+        bool hasNextImpulseResponse = false;
+        bool isActive = false;
+
+        std::vector<HeapBlock<float>> frame, output, jobInput, jobOutput, missedFrame;
+
+        // the same buffers as pointer tables, for the engine's batched frame calls
+        std::vector<const float*> framePointers, jobInputPointers, missedFramePointers;
+        std::vector<float*> outputPointers, jobOutputPointers;
+
+        std::atomic<int> jobState { idle };
+
+        // only touched by the audio thread, apart from replayMissedFrame, which the worker reads with its job
+        int numMissedFrames = 0;
+        bool replayMissedFrame = false;
+        bool needsReset = false;    // reset() came while the worker had the engine
+    };
+
+    class Worker : public Thread
+    {
+    public:
+        Worker (NonUniformPartitionedConvolution& o) : Thread ("NonUniformConvolution"), owner (o) {}
+        void run () override;
+
+    private:
+        NonUniformPartitionedConvolution& owner;
+    };
+
+    void processSegment (Segment& segment, const dsp::AudioBlock<SampleType>& input, const dsp::AudioBlock<SampleType>& output);
+    void finishFrame (Segment& segment);
+    void runJob (Segment& segment);
+
+    dsp::ProcessorDuplicator<dsp::FIR::Filter<SampleType>, Coefficients> head;
+    std::vector<std::unique_ptr<Segment>> segments;
+    Worker worker { *this };
+
+    AudioBuffer<SampleType> inputCopy;
+
+    int numChannels = 0;
+    int64 samplePosition = 0;
+    bool nonRealtime = false;
+    std::atomic<int> deadlineMisses { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NonUniformPartitionedConvolution)
+};
@@ -0,0 +1,233 @@
+#include "PartitionedConvolution.h"
+
+PartitionedImpulseResponse::PartitionedImpulseResponse (const float* impulseResponse, int taps, int size)
+    : partitionSize (size),
+      numPartitions (jmax (1, (taps + size - 1) / size)),
+      numBins (size + 1),
+      numTaps (taps)
+{
+    jassert (isPowerOfTwo (partitionSize));
+
+    const auto fftSize = 2 * partitionSize;
+    dsp::FFT fft (roundToInt (std::log2 (fftSize)));
+
+    HeapBlock<float> buffer ((size_t)fftSize * 2, true);
+    spectra.allocate ((size_t)numPartitions * 2 * (size_t)numBins, true);
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto offset = p * partitionSize;
+        const auto numToCopy = jmax (0, jmin (partitionSize, numTaps - offset));
+
+        FloatVectorOperations::clear (buffer.get (), fftSize * 2);
+        FloatVectorOperations::copy (buffer.get (), impulseResponse + offset, numToCopy);
+
+        fft.performRealOnlyForwardTransform (buffer.get (), true);
+
+        auto* re = const_cast<float*> (getReal (p));
+        auto* im = const_cast<float*> (getImag (p));
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            re[k] = buffer[2 * k];
+            im[k] = buffer[2 * k + 1];
+        }
+    }
+}
+
+//==============================================================================
+int UniformPartitionedConvolution::getPartitionSizeForBlockSize (int maximumBlockSize)
+{
+    return jmax (64, nextPowerOfTwo (maximumBlockSize));
+}
+
+void UniformPartitionedConvolution::prepare (const Spec& spec, int size, int maxNumTaps, int delayInPartitions)
+{
+    jassert (isPowerOfTwo (size));
+    jassert (delayInPartitions >= 0);
+
+    partitionSize = size;
+    numBins = partitionSize + 1;
+    maxNumPartitions = jmax (1, (maxNumTaps + partitionSize - 1) / partitionSize);
+    delay = delayInPartitions;
+    numSlots = maxNumPartitions + delay;
+
+    const auto fftSize = 2 * partitionSize;
+    fft = std::make_unique<dsp::FFT> (roundToInt (std::log2 (fftSize)));
+    fftBuffer.allocate ((size_t)fftSize * 2, true);
+    channels.resize (spec.numChannels);
+    accumulators.allocate ((size_t)numBins * 2 * channels.size (), true);
+
+    for (auto& channel : channels)
+    {
+        channel.input.allocate ((size_t)fftSize, true);
+        channel.output.allocate ((size_t)partitionSize, true);
+        channel.delayLine.allocate ((size_t)numSlots * 2 * (size_t)numBins, true);
+    }
+
+    reset ();
+}
+
+void UniformPartitionedConvolution::setImpulseResponse (PartitionedImpulseResponse::Ptr newImpulseResponse)
+{
+    jassert (newImpulseResponse == nullptr || newImpulseResponse->partitionSize == partitionSize);
+    jassert (newImpulseResponse == nullptr || newImpulseResponse->numPartitions <= maxNumPartitions);
+
+    std::swap (impulseResponse, newImpulseResponse);
+}
+
+void UniformPartitionedConvolution::setKernels (KernelStore::Ptr newKernels, int firstChannel)
+{
+    jassert (newKernels == nullptr || newKernels->partitionSize == partitionSize);
+
+    std::swap (kernels, newKernels);
+    firstKernelChannel = firstChannel;
+}
+
+void UniformPartitionedConvolution::reset ()
+{
+    for (auto& channel : channels)
+    {
+        channel.input.clear ((size_t)partitionSize * 2);
+        channel.output.clear ((size_t)partitionSize);
+        channel.delayLine.clear ((size_t)numSlots * 2 * (size_t)numBins);
+        channel.delayLineIndex = 0;
+    }
+
+    framePosition = 0;
+}
+
+void UniformPartitionedConvolution::process (const Context& context)
+{
+    auto& inputBlock = context.getInputBlock ();
+    auto& outputBlock = context.getOutputBlock ();
+
+    const auto numChannels = jmin (outputBlock.getNumChannels (), channels.size ());
+    const auto numSamples = (int)inputBlock.getNumSamples ();
+
+    int done = 0;
+    int position = framePosition;
+
+    while (done < numSamples)
+    {
+        const auto numThisTime = jmin (numSamples - done, partitionSize - position);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channel = channels[ch];
+
+            // input is stored before the output is written, so in place processing is fine
+            FloatVectorOperations::copy (channel.input + partitionSize + position, inputBlock.getChannelPointer (ch) + done, numThisTime);
+            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch) + done, channel.output + position, numThisTime);
+        }
+
+        if (position + numThisTime == partitionSize)
+            processFrames ();
+
+        position = (position + numThisTime) % partitionSize;
+        done += numThisTime;
+    }
+
+    framePosition = position;
+}
+
+void UniformPartitionedConvolution::processFrames (const float* const* inputs, float* const* outputs)
+{
+    for (size_t ch = 0; ch < channels.size (); ++ch)
+        FloatVectorOperations::copy (channels[ch].input + partitionSize, inputs[ch], partitionSize);
+
+    processFrames ();
+
+    for (size_t ch = 0; ch < channels.size (); ++ch)
+        FloatVectorOperations::copy (outputs[ch], channels[ch].output.get (), partitionSize);
+}
+
+void UniformPartitionedConvolution::processFrames ()
+{
+    const auto fftSize = 2 * partitionSize;
+    const auto spectrumSize = 2 * numBins;
+    const auto numChannels = channels.size ();
+
+    // store every channel's new input spectrum in its frequency-domain delay line
+    for (auto& channel : channels)
+    {
+        FloatVectorOperations::copy (fftBuffer.get (), channel.input.get (), fftSize);
+        FloatVectorOperations::clear (fftBuffer + fftSize, fftSize);
+        fft->performRealOnlyForwardTransform (fftBuffer.get (), true);
+
+        channel.delayLineIndex = (channel.delayLineIndex + 1) % numSlots;
+
+        auto* slotRe = channel.delayLine + (size_t)channel.delayLineIndex * (size_t)spectrumSize;
+        auto* slotIm = slotRe + numBins;
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            slotRe[k] = fftBuffer[2 * k];
+            slotIm[k] = fftBuffer[2 * k + 1];
+        }
+    }
+
+    // multiply-accumulate every partition with the input spectra it lines up with, all channels at once
+    FloatVectorOperations::clear (accumulators.get (), spectrumSize * (int)numChannels);
+
+    auto numPartitions = impulseResponse != nullptr ? impulseResponse->numPartitions : 0;
+
+    if (kernels != nullptr)
+        numPartitions = kernels->maxNumPartitions;
+
+    numPartitions = jmin (numPartitions, maxNumPartitions);
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto* hRe = impulseResponse != nullptr ? impulseResponse->getReal (p) : nullptr;
+        const auto* hIm = impulseResponse != nullptr ? impulseResponse->getImag (p) : nullptr;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channel = channels[ch];
+
+            if (kernels != nullptr)
+            {
+                const auto kernel = kernels->getChannelKernel (firstKernelChannel + (int)ch);
+
+                if (kernel < 0 || p >= kernels->getNumPartitions (kernel))
+                    continue;
+
+                hRe = kernels->getReal (kernel, p);
+                hIm = kernels->getImag (kernel, p);
+            }
+
+            const auto slot = (channel.delayLineIndex - p - delay + numSlots) % numSlots;
+            const auto* xRe = channel.delayLine + (size_t)slot * (size_t)spectrumSize;
+            const auto* xIm = xRe + numBins;
+
+            auto* accRe = accumulators + ch * (size_t)spectrumSize;
+            auto* accIm = accRe + numBins;
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+                accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+            }
+        }
+    }
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto& channel = channels[ch];
+        const auto* accRe = accumulators + ch * (size_t)spectrumSize;
+        const auto* accIm = accRe + numBins;
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            fftBuffer[2 * k] = accRe[k];
+            fftBuffer[2 * k + 1] = accIm[k];
+        }
+
+        fft->performRealOnlyInverseTransform (fftBuffer.get ());
+
+        // overlap-save: only the second half of the circular convolution is valid
+        FloatVectorOperations::copy (channel.output.get (), fftBuffer + partitionSize, partitionSize);
+        FloatVectorOperations::copy (channel.input.get (), channel.input + partitionSize, partitionSize);
+    }
+}
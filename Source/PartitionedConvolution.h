@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KernelStore.h"
+
+/** The spectra of an impulse response cut into equally sized partitions.
+
+    Built off the audio thread whenever new coefficients are designed, so that swapping
+    them into a UniformPartitionedConvolution is only a pointer exchange. Each partition
+    holds partitionSize taps zero padded to an FFT of 2 * partitionSize, stored as split
+    real / imaginary arrays of numBins = partitionSize + 1 values.
+*/
+struct PartitionedImpulseResponse : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<PartitionedImpulseResponse>;
+
+    PartitionedImpulseResponse (const float* impulseResponse, int numTaps, int partitionSize);
+
+    const float* getReal (int partition) const { return spectra.get () + (size_t)partition * 2 * (size_t)numBins; }
+    const float* getImag (int partition) const { return getReal (partition) + numBins; }
+
+    int partitionSize;
+    int numPartitions;
+    int numBins;
+    int numTaps;
+
+    HeapBlock<float> spectra;
+};
+
+/** Uniformly-partitioned overlap-save FFT convolution.
+
+    Every channel keeps a frequency-domain delay line with the spectra of its past input
+    frames. Once partitionSize new samples have arrived the frame is transformed, multiplied
+    with all partition spectra and transformed back, so the cost per sample is roughly
+    O(log partitionSize + numPartitions) instead of O(numTaps).
+
+    All channels complete their frames together and are convolved in one batch: each
+    partition spectrum is read once per frame and applied to every channel's delay line
+    while it is still in cache, so the multiply-add cost grows with the number of channels
+    but the traffic for the impulse response does not.
+
+    Blocks of any size up to partitionSize can be processed; the latency is always exactly
+    partitionSize samples.
+*/
+class UniformPartitionedConvolution
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+
+    /** Allocates everything needed for impulse responses of up to maxNumTaps.
+
+        delayInPartitions shifts the whole response back by that many partitions without
+        any extra multiplies, which is how the later segments of a non-uniform scheme line up.
+    */
+    void prepare (const Spec& spec, int partitionSize, int maxNumTaps, int delayInPartitions = 0);
+
+    /** Swaps in a new set of partition spectra. Does not allocate, call from the audio thread. */
+    void setImpulseResponse (PartitionedImpulseResponse::Ptr newImpulseResponse);
+
+    /** Gives every channel its own kernel instead; channel ch runs through the kernel the
+        store selects for channel firstChannel + ch. While a store is set the impulse
+        response is ignored. Does not allocate, call from the audio thread.
+    */
+    void setKernels (KernelStore::Ptr newKernels, int firstChannel = 0);
+
+    void reset ();
+    void process (const Context& context);
+
+    /** Convolves exactly one partition of input for every channel without buffering.
+
+        inputs and outputs hold one pointer per prepared channel. The output covers the same
+        partitionSize samples as the input, so the result carries no latency apart from the
+        delayInPartitions given to prepare(). process() must not be used on the same instance.
+    */
+    void processFrames (const float* const* inputs, float* const* outputs);
+
+    int getPartitionSize () const { return partitionSize; }
+    int getLatencyInSamples () const { return partitionSize; }
+
+    /** Returns a partition size suitable for the given block size. */
+    static int getPartitionSizeForBlockSize (int maximumBlockSize);
+
+private:
+    struct Channel
+    {
+        HeapBlock<float> input;     // last 2 * partitionSize input samples
+        HeapBlock<float> output;    // partitionSize samples produced by the last frame
+        HeapBlock<float> delayLine; // numSlots spectra, split real / imaginary
+        int delayLineIndex = 0;
+    };
+
+    void processFrames ();
+
+    std::unique_ptr<dsp::FFT> fft;
+    HeapBlock<float> fftBuffer;
+    HeapBlock<float> accumulators;  // one spectrum per channel
+
+    std::vector<Channel> channels;
+
+    PartitionedImpulseResponse::Ptr impulseResponse;
+    KernelStore::Ptr kernels;
+    int firstKernelChannel = 0;
+
+    int partitionSize = 0;
+    int numBins = 0;
+    int maxNumPartitions = 0;
+    int delay = 0;
+    int numSlots = 0;
+    int framePosition = 0;
+};
@@ -14,10 +14,10 @@
 FIRAttemptsAudioProcessorEditor::FIRAttemptsAudioProcessorEditor (FIRAttemptsAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {    
-    ui = std::make_unique<AutoUI> (audioProcessor);
+    ui = std::make_unique<AutoUI> (audioProcessor, &audioProcessor.getFilter ());
     addAndMakeVisible (ui.get());
 
-    setSize (400, 300);
+    setSize (600, 640);
     setResizable (true, true);
 }
 
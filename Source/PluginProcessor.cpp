@@ -110,12 +110,11 @@ bool FIRAttemptsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets the same filter, so any layout works as long as the interleaved
+    // kernels can take all channels in one group: up to 7.1.4 or third order Ambisonics.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > FirFilter::maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -129,7 +128,18 @@ bool FIRAttemptsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 }
 #endif
 
-void FIRAttemptsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void FIRAttemptsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    process (buffer);
+}
+
+void FIRAttemptsAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    process (buffer);
+}
+
+template <typename SampleType>
+void FIRAttemptsAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     const auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -144,8 +154,8 @@ void FIRAttemptsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    dsp::AudioBlock<float> block{ buffer };
-    dsp::ProcessContextReplacing<float> context{ block };
+    dsp::AudioBlock<SampleType> block{ buffer };
+    dsp::ProcessContextReplacing<SampleType> context{ block };
 
     filter.process (context);
 }
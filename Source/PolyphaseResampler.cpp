@@ -0,0 +1,304 @@
+#include "PolyphaseResampler.h"
+
+HalfBandKernel::HalfBandKernel (const dsp::FIR::Coefficients<float>& halfBand)
+    : numTaps ((int)halfBand.getFilterSize ()),
+      centre ((numTaps - 1) / 2)
+{
+    const auto* h = halfBand.getRawCoefficients ();
+
+    for (int k = 0; k < numTaps; ++k)
+    {
+        if (h[k] == 0.0f)
+            continue;
+
+        taps.push_back ({ k, h[k] });
+
+        // zero stuffing halves the gain, which the interpolation branches make up for
+        if (k % 2 == 0)
+            evenTaps.push_back ({ k / 2, 2.0f * h[k] });
+        else
+            oddTaps.push_back ({ k / 2, 2.0f * h[k] });
+    }
+}
+
+//==============================================================================
+void HalfBandStage::prepare (int numChannels, int maxNumInputs, int maxNumTaps)
+{
+    historySize = maxNumTaps;
+    capacity = historySize + jmax (4 * maxNumInputs, historySize);
+
+    channels.resize ((size_t)numChannels);
+
+    for (auto& channel : channels)
+        channel.history.allocate ((size_t)capacity, true);
+
+    reset ();
+}
+
+void HalfBandStage::reset ()
+{
+    for (auto& channel : channels)
+    {
+        channel.history.clear ((size_t)capacity);
+        channel.writePosition = historySize;
+    }
+
+    phase = 0;
+}
+
+void HalfBandStage::setKernel (HalfBandKernel::Ptr newKernel)
+{
+    jassert (newKernel == nullptr || newKernel->numTaps <= historySize);
+
+    std::swap (kernel, newKernel);
+}
+
+float* HalfBandStage::append (Channel& channel, const float* input, int numInputs)
+{
+    jassert (numInputs <= capacity - historySize);
+
+    if (channel.writePosition + numInputs > capacity)
+    {
+        // the ranges overlap for blocks shorter than the history, which std::copy allows when moving down
+        const auto* source = channel.history + channel.writePosition - historySize;
+        std::copy (source, source + historySize, channel.history.get ());
+        channel.writePosition = historySize;
+    }
+
+    auto* x = channel.history + channel.writePosition;
+    FloatVectorOperations::copy (x, input, numInputs);
+    channel.writePosition += numInputs;
+
+    return x;
+}
+
+int HalfBandStage::decimate (int channelIndex, const float* input, float* output, int numInputs)
+{
+    const auto* x = append (channels[(size_t)channelIndex], input, numInputs);
+    int numOutputs = 0;
+
+    // an output is due whenever the input with even index (counting across calls) arrives
+    for (int i = phase; i < numInputs; i += 2)
+    {
+        auto sum = 0.0f;
+
+        if (kernel != nullptr)
+            for (auto& tap : kernel->taps)
+                sum += tap.coefficient * x[i - tap.offset];
+
+        output[numOutputs++] = sum;
+    }
+
+    return numOutputs;
+}
+
+void HalfBandStage::interpolate (int channelIndex, const float* input, float* output, int numInputs)
+{
+    const auto* x = append (channels[(size_t)channelIndex], input, numInputs);
+
+    if (kernel == nullptr)
+    {
+        FloatVectorOperations::clear (output, 2 * numInputs);
+        return;
+    }
+
+    for (int i = 0; i < numInputs; ++i)
+    {
+        auto even = 0.0f;
+        auto odd = 0.0f;
+
+        for (auto& tap : kernel->evenTaps)
+            even += tap.coefficient * x[i - tap.offset];
+
+        for (auto& tap : kernel->oddTaps)
+            odd += tap.coefficient * x[i - tap.offset];
+
+        output[2 * i] = even;
+        output[2 * i + 1] = odd;
+    }
+}
+
+//==============================================================================
+ResamplingCascade::ResamplingCascade (int stages, double protectedBandwidth, float attenuationdB)
+    : numStages (stages)
+{
+    jassert (numStages >= -maxNumStages && numStages <= maxNumOversamplingStages);
+
+    const auto bandwidth = numStages > 0 ? 0.5 - minTransitionWidth : protectedBandwidth;
+
+    for (int s = 0; s < std::abs (numStages); ++s)
+    {
+        // the higher of the two rates this stage runs at, relative to the host rate
+        const auto rate = numStages > 0 ? std::ldexp (1.0, s + 1) : std::ldexp (1.0, -s);
+
+        // the pass band ends at the protected bandwidth, and the stop band starts where its
+        // mirror image around a quarter of the rate begins
+        const auto transitionWidth = jlimit (minTransitionWidth, 0.45, 0.5 - 2.0 * bandwidth / rate);
+
+        auto halfBand = dsp::FilterDesign<float>::designFIRLowpassHalfBandEquirippleMethod ((float)transitionWidth, attenuationdB);
+        kernels.emplace_back (new HalfBandKernel (*halfBand));
+    }
+}
+
+int ResamplingCascade::getMaxNumDecimationStages (double bandwidth, int maxStages)
+{
+    // after s stages the narrowest allowed transition band still has to fit above the bandwidth
+    for (int stages = jmin (maxStages, maxNumStages); stages > 0; --stages)
+        if (bandwidth <= (0.25 - minTransitionWidth / 2.0) / std::ldexp (1.0, stages - 1))
+            return stages;
+
+    return 0;
+}
+
+double ResamplingCascade::getDelayInSamples () const
+{
+    auto latency = 0.0;
+
+    for (int s = 0; s < (int)kernels.size (); ++s)
+    {
+        // each stage delays by the half-band's centre twice, at the stage's higher rate
+        const auto delay = 2.0 * kernels[(size_t)s]->centre;
+        latency += numStages > 0 ? delay / std::ldexp (1.0, s + 1) : delay * std::ldexp (1.0, s);
+    }
+
+    return latency;
+}
+
+//==============================================================================
+void PolyphaseResampler::prepare (const Spec& spec)
+{
+    maximumBlockSize = (int)spec.maximumBlockSize;
+
+    const auto numChannels = (int)spec.numChannels;
+
+    for (int s = 0; s < ResamplingCascade::maxNumStages; ++s)
+    {
+        // only oversampling makes blocks larger than the host's; decimated ones always fit in one block
+        const auto maxNumSamples = s < ResamplingCascade::maxNumOversamplingStages ? maximumBlockSize << (s + 1) : maximumBlockSize;
+
+        decimators[(size_t)s].prepare (numChannels, maxNumSamples, ResamplingCascade::maxNumTaps);
+        interpolators[(size_t)s].prepare (numChannels, maxNumSamples, ResamplingCascade::maxNumTaps);
+        internalBuffers[(size_t)s].setSize (numChannels, maxNumSamples + 8);
+    }
+
+    fifo.setSize (numChannels, maximumBlockSize + 2 * (1 << ResamplingCascade::maxNumStages));
+
+    reset ();
+}
+
+void PolyphaseResampler::reset ()
+{
+    for (int s = 0; s < ResamplingCascade::maxNumStages; ++s)
+    {
+        decimators[(size_t)s].reset ();
+        interpolators[(size_t)s].reset ();
+    }
+
+    fifo.clear ();
+    numInFifo = 0;
+}
+
+void PolyphaseResampler::setCascade (ResamplingCascade::Ptr newCascade)
+{
+    for (int s = 0; s < ResamplingCascade::maxNumStages; ++s)
+    {
+        auto kernel = newCascade != nullptr && s < (int)newCascade->kernels.size () ? newCascade->kernels[(size_t)s] : nullptr;
+
+        decimators[(size_t)s].setKernel (kernel);
+        interpolators[(size_t)s].setKernel (kernel);
+    }
+
+    std::swap (cascade, newCascade);
+}
+
+int PolyphaseResampler::toInternalRate (const dsp::AudioBlock<const SampleType>& input, int numStages)
+{
+    const auto numChannels = jmin (input.getNumChannels (), (size_t)fifo.getNumChannels ());
+    auto numSamples = (int)input.getNumSamples ();
+
+    if (numStages > 0)
+    {
+        for (int s = 0; s < numStages; ++s)
+        {
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* source = s == 0 ? input.getChannelPointer (ch) : internalBuffers[(size_t)s - 1].getReadPointer ((int)ch);
+                interpolators[(size_t)s].interpolate ((int)ch, source, internalBuffers[(size_t)s].getWritePointer ((int)ch), numSamples);
+            }
+
+            numSamples *= 2;
+        }
+
+        return numSamples;
+    }
+
+    for (int s = 0; s < -numStages; ++s)
+    {
+        auto& stage = decimators[(size_t)s];
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* source = s == 0 ? input.getChannelPointer (ch) : internalBuffers[(size_t)s - 1].getReadPointer ((int)ch);
+            stage.decimate ((int)ch, source, internalBuffers[(size_t)s].getWritePointer ((int)ch), numSamples);
+        }
+
+        const auto numOutputs = stage.getNumDecimatedSamples (numSamples);
+        stage.advance (numSamples);
+        numSamples = numOutputs;
+    }
+
+    return numSamples;
+}
+
+void PolyphaseResampler::fromInternalRate (const dsp::AudioBlock<SampleType>& output, int numInternal, int numStages)
+{
+    const auto numChannels = jmin (output.getNumChannels (), (size_t)fifo.getNumChannels ());
+    const auto numSamples = (int)output.getNumSamples ();
+
+    if (numStages > 0)
+    {
+        auto count = numInternal;
+
+        for (int s = numStages - 1; s >= 0; --s)
+        {
+            auto& stage = decimators[(size_t)s];
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* destination = s == 0 ? output.getChannelPointer (ch) : internalBuffers[(size_t)s - 1].getWritePointer ((int)ch);
+                stage.decimate ((int)ch, internalBuffers[(size_t)s].getReadPointer ((int)ch), destination, count);
+            }
+
+            stage.advance (count);
+            count /= 2;
+        }
+
+        return;
+    }
+
+    // interpolate back into the FIFO, then hand out exactly one host block and keep the rest
+    auto count = numInternal;
+
+    for (int s = -numStages - 1; s >= 0; --s)
+    {
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* destination = s == 0 ? fifo.getWritePointer ((int)ch, numInFifo) : internalBuffers[(size_t)s - 1].getWritePointer ((int)ch);
+            interpolators[(size_t)s].interpolate ((int)ch, internalBuffers[(size_t)s].getReadPointer ((int)ch), destination, count);
+        }
+
+        count *= 2;
+    }
+
+    numInFifo += count;
+    jassert (numInFifo >= numSamples);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = fifo.getWritePointer ((int)ch);
+        FloatVectorOperations::copy (output.getChannelPointer (ch), data, numSamples);
+        std::copy (data + numSamples, data + numInFifo, data);   // may overlap, so not a memcpy
+    }
+
+    numInFifo -= numSamples;
+}
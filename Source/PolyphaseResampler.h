@@ -0,0 +1,182 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** The non-zero taps of a half-band lowpass, split up for both directions of a stage.
+
+    A half-band set has every second tap away from the centre at zero, so only about half
+    of the taps are kept. Built off the audio thread and shared by reference.
+*/
+struct HalfBandKernel : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<HalfBandKernel>;
+
+    explicit HalfBandKernel (const dsp::FIR::Coefficients<float>& halfBand);
+
+    struct Tap
+    {
+        int offset;
+        float coefficient;
+    };
+
+    std::vector<Tap> taps;                  // decimation: offsets at the higher rate
+    std::vector<Tap> evenTaps, oddTaps;     // interpolation: the two polyphase branches, offsets at the lower rate
+
+    int numTaps = 0;
+    int centre = 0;
+};
+
+/** One factor of two sample rate change with a half-band lowpass.
+
+    Only the outputs that are kept are computed, and only the non-zero taps are used, so
+    decimating or interpolating costs about a quarter of running the full filter at the
+    higher rate. Both directions keep a linear input history per channel, like
+    DirectConvolution.
+*/
+class HalfBandStage
+{
+public:
+    /** maxNumInputs is the largest number of samples passed to a single call. */
+    void prepare (int numChannels, int maxNumInputs, int maxNumTaps);
+    void reset ();
+
+    /** Swaps in a new kernel. Does not allocate, call from the audio thread. */
+    void setKernel (HalfBandKernel::Ptr newKernel);
+
+    /** Number of samples decimate() will produce for numInputs, given the current phase. */
+    int getNumDecimatedSamples (int numInputs) const { return (numInputs + 1 - phase) / 2; }
+
+    /** Writes every second sample of the filtered input. Call advance() once all channels are done. */
+    int decimate (int channel, const float* input, float* output, int numInputs);
+
+    /** Writes two samples for every input sample. */
+    void interpolate (int channel, const float* input, float* output, int numInputs);
+
+    void advance (int numInputs) { phase = (phase + numInputs) % 2; }
+
+private:
+    struct Channel
+    {
+        HeapBlock<float> history;
+        int writePosition = 0;
+    };
+
+    float* append (Channel& channel, const float* input, int numInputs);
+
+    HalfBandKernel::Ptr kernel;
+    std::vector<Channel> channels;
+    int historySize = 0;
+    int capacity = 0;
+    int phase = 0;
+};
+
+/** The half-band kernels of every stage of a resampling cascade.
+
+    Positive stage counts oversample by 2 per stage, negative counts decimate. Each stage
+    only has to keep the protected band free of aliases and images, and at the lower rates
+    of a decimating cascade that band is small compared to the stage's sample rate, so the
+    transition bands widen and the kernels shrink to a handful of taps; most of the
+    selectivity is left to the filter in the middle of the cascade. All stages reach the
+    given stop band attenuation.
+*/
+struct ResamplingCascade : public ReferenceCountedObject
+{
+    using Ptr = ReferenceCountedObjectPtr<ResamplingCascade>;
+
+    static constexpr int maxNumStages = 8;
+    static constexpr int maxNumOversamplingStages = 2;
+
+    /** Narrowest transition width used by any stage, relative to its higher sample rate. */
+    static constexpr double minTransitionWidth = 0.05;
+
+    /** Longest kernel any stage may need. */
+    static constexpr int maxNumTaps = 512;
+
+    /** protectedBandwidth is relative to the host rate and only used when decimating;
+        oversampling always keeps everything below 0.45 of the host rate intact.
+    */
+    ResamplingCascade (int numStages, double protectedBandwidth, float attenuationdB);
+
+    /** Most decimating stages that keep everything below bandwidth (relative to the host rate) intact. */
+    static int getMaxNumDecimationStages (double bandwidth, int maxStages = maxNumStages);
+
+    /** Delay of the whole cascade, down and up again, in host rate samples. Not rounded, so
+        that it can be added to the delay of the filter between the stages first.
+    */
+    double getDelayInSamples () const;
+
+    int numStages;
+    std::vector<HalfBandKernel::Ptr> kernels;   // stage 0 runs next to the host rate
+};
+
+/** Runs a processor at a power of two multiple or fraction of the host sample rate.
+
+    The block is passed through the stages of the current ResamplingCascade, processed at
+    the internal rate in chunks of at most the prepared block size, and passed back through
+    the stages in reverse. Decimating lets a steep or narrowband lowpass run at a fraction
+    of the rate with correspondingly fewer taps.
+
+    When the host block size is not a multiple of the factor, decimating rounds the number
+    of internal samples up, and the few extra samples interpolated back are kept in a small
+    FIFO for the next block. This adds no latency.
+*/
+class PolyphaseResampler
+{
+public:
+    using SampleType = float;
+    using Context = dsp::ProcessContextReplacing<SampleType>;
+    using Spec = dsp::ProcessSpec;
+
+    void prepare (const Spec& spec);
+    void reset ();
+
+    /** Swaps in a new cascade. Does not allocate, call from the audio thread. Changing the
+        number of stages should be followed by reset().
+    */
+    void setCascade (ResamplingCascade::Ptr newCascade);
+
+    int getNumStages () const { return cascade != nullptr ? cascade->numStages : 0; }
+
+    /** Converts the block to the internal rate, calls processInternal with blocks of at most the
+        prepared maximum block size, and converts the result back into the block.
+    */
+    template <typename Callback>
+    void process (const Context& context, Callback&& processInternal)
+    {
+        const auto numStages = getNumStages ();
+
+        if (numStages == 0)
+        {
+            processInternal (context);
+            return;
+        }
+
+        const auto numChannels = jmin (context.getOutputBlock ().getNumChannels (), (size_t)fifo.getNumChannels ());
+        const auto numInternal = toInternalRate (context.getInputBlock (), numStages);
+
+        dsp::AudioBlock<SampleType> internalBlock (internalBuffers[(size_t)std::abs (numStages) - 1]);
+        internalBlock = internalBlock.getSubsetChannelBlock (0, numChannels);
+
+        for (int start = 0; start < numInternal; start += maximumBlockSize)
+        {
+            auto chunk = internalBlock.getSubBlock ((size_t)start, (size_t)jmin (maximumBlockSize, numInternal - start));
+            processInternal (Context (chunk));
+        }
+
+        fromInternalRate (context.getOutputBlock (), numInternal, numStages);
+    }
+
+private:
+    int toInternalRate (const dsp::AudioBlock<const SampleType>& input, int numStages);
+    void fromInternalRate (const dsp::AudioBlock<SampleType>& output, int numInternal, int numStages);
+
+    std::array<HalfBandStage, ResamplingCascade::maxNumStages> decimators, interpolators;
+    ResamplingCascade::Ptr cascade;
+
+    // internalBuffers[s] holds the signal after s + 1 stages
+    std::array<AudioBuffer<SampleType>, ResamplingCascade::maxNumStages> internalBuffers;
+    AudioBuffer<SampleType> fifo;
+    int numInFifo = 0;
+
+    int maximumBlockSize = 0;
+};
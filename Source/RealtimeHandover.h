@@ -0,0 +1,126 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Keeps reference counted objects alive until nothing but the pool refers to them.
+
+    Everything the audio thread may hold a reference to is added here when it is created.
+    The audio thread can then drop references freely without ever releasing the last one,
+    and releaseUnused(), called regularly from the message thread, frees the objects that
+    are no longer used anywhere. Objects may be shared between filter sets and caches.
+*/
+class ReleasePool
+{
+public:
+    template <typename ObjectType>
+    void add (const ReferenceCountedObjectPtr<ObjectType>& object)
+    {
+        if (object == nullptr)
+            return;
+
+        const ScopedLock sl (lock);
+
+        if (std::find (objects.begin (), objects.end (), object.get ()) == objects.end ())
+            objects.emplace_back (object.get ());
+    }
+
+    void releaseUnused ()
+    {
+        const ScopedLock sl (lock);
+
+        // a count of one is the pool's own reference, and nobody can take a new one from it
+        objects.erase (std::remove_if (objects.begin (), objects.end (), [] (const auto& object) { return object->getReferenceCount () == 1; }),
+                       objects.end ());
+    }
+
+private:
+    CriticalSection lock;
+    std::vector<ReferenceCountedObjectPtr<ReferenceCountedObject>> objects;
+};
+
+/** Hands objects built on a non-realtime thread over to the audio thread without locks.
+
+    publish() stores a new object in a single atomic slot, replacing (and deleting) one the
+    audio thread has not picked up yet. acquire() takes whatever is in the slot and makes it
+    current; the previously current object goes into a fixed size FIFO instead of being
+    destroyed, and collectGarbage(), called regularly from the message thread, deletes it.
+    The audio thread therefore never allocates, frees, blocks or waits.
+
+    Data the engines keep references to after the object is retired must be kept alive by
+    a ReleasePool.
+*/
+template <typename ObjectType>
+class RealtimeHandover
+{
+public:
+    RealtimeHandover () = default;
+
+    ~RealtimeHandover ()
+    {
+        clear ();
+    }
+
+    /** Message thread: makes newObject the next one the audio thread will pick up. */
+    void publish (std::unique_ptr<ObjectType> newObject)
+    {
+        // never seen by the audio thread, so nothing can still refer to it
+        std::unique_ptr<ObjectType> unused (pending.exchange (newObject.release ()));
+    }
+
+    /** Audio thread: returns the newly published object, or nullptr if there is none.
+        The returned object stays current until the next successful acquire().
+    */
+    ObjectType* acquire () noexcept
+    {
+        // if the message thread has fallen behind, keep the current object for now
+        if (retired.getFreeSpace () == 0)
+            return nullptr;
+
+        auto* incoming = pending.exchange (nullptr);
+
+        if (incoming == nullptr)
+            return nullptr;
+
+        if (current != nullptr)
+        {
+            const auto scope = retired.write (1);
+            retiredObjects[(size_t)scope.startIndex1] = current;
+        }
+
+        current = incoming;
+        return current;
+    }
+
+    /** Audio thread: the object returned by the last successful acquire(). */
+    ObjectType* getCurrent () const noexcept { return current; }
+
+    /** Message thread: deletes the objects the audio thread has retired. */
+    void collectGarbage ()
+    {
+        const ScopedLock sl (readLock);
+
+        const auto scope = retired.read (retired.getNumReady ());
+        scope.forEach ([this] (int index) { delete retiredObjects[(size_t)index]; });
+    }
+
+    /** Deletes the current and pending objects. Only call while the audio thread is stopped. */
+    void clear ()
+    {
+        collectGarbage ();
+
+        std::unique_ptr<ObjectType> unused (pending.exchange (nullptr));
+        std::unique_ptr<ObjectType> previous (std::exchange (current, nullptr));
+    }
+
+private:
+    static constexpr int fifoSize = 64;
+
+    std::atomic<ObjectType*> pending { nullptr };
+    ObjectType* current = nullptr;
+
+    AbstractFifo retired { fifoSize };
+    std::array<ObjectType*, fifoSize> retiredObjects {};
+    CriticalSection readLock;
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeHandover)
+};
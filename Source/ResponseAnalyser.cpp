@@ -0,0 +1,201 @@
+#include "ResponseAnalyser.h"
+
+namespace
+{
+    constexpr int refreshRate = 30;
+    constexpr float spectrumSmoothing = 0.7f;
+
+    float toDecibels (float power)
+    {
+        return 10.f * std::log10 (jmax (power, 1.0e-20f));
+    }
+}
+
+ResponseAnalyser::ResponseAnalyser (FirFilter& f)
+    : Thread ("FIR response"), filter (f)
+{
+    inputHistory.resize ((size_t)spectrumSize);
+    outputHistory.resize ((size_t)spectrumSize);
+    readBuffer.resize ((size_t)SignalTap::capacity * 2);
+    fftBuffer.resize ((size_t)spectrumSize * 2);
+    inputPower.resize ((size_t)spectrumSize / 2 + 1);
+    outputPower.resize ((size_t)spectrumSize / 2 + 1);
+
+    filter.getSignalTap ().setActive (true);
+    startThread (Priority::low);
+}
+
+ResponseAnalyser::~ResponseAnalyser ()
+{
+    filter.getSignalTap ().setActive (false);
+    stopThread (1000);
+}
+
+bool ResponseAnalyser::getCurves (Curves& destination) const
+{
+    const SpinLock::ScopedTryLockType tl (curvesLock);
+
+    if (! tl.isLocked () || destination.version == curves.version)
+        return false;
+
+    destination = curves;
+    return true;
+}
+
+void ResponseAnalyser::run ()
+{
+    while (! threadShouldExit ())
+    {
+        auto changed = false;
+
+        if (const auto version = filter.getActiveCoefficientsVersion (); version != coefficientsVersion)
+        {
+            coefficientsVersion = version;
+
+            double sampleRate = 0.0;
+
+            if (auto coefficients = filter.getActiveCoefficients (sampleRate); coefficients != nullptr && sampleRate > 0.0)
+            {
+                analyseResponse (*coefficients, sampleRate);
+            }
+            else
+            {
+                working.responseFrequencies.clear ();
+                working.magnitudeDecibels.clear ();
+                working.phase.clear ();
+                working.groupDelayMilliseconds.clear ();
+            }
+
+            changed = true;
+        }
+
+        if (const auto sampleRate = filter.getSampleRate (); sampleRate > 0.0)
+        {
+            const auto numRead = filter.getSignalTap ().read (readBuffer.data (), readBuffer.data () + SignalTap::capacity, SignalTap::capacity);
+
+            if (numRead > 0)
+            {
+                // only the latest spectrumSize samples matter
+                for (auto [history, source] : { std::pair (&inputHistory, readBuffer.data ()), std::pair (&outputHistory, readBuffer.data () + SignalTap::capacity) })
+                {
+                    const auto numKept = jmax (0, spectrumSize - numRead);
+                    const auto numNew = jmin (numRead, spectrumSize);
+
+                    std::move (history->end () - numKept, history->end (), history->begin ());
+                    std::copy_n (source + numRead - numNew, numNew, history->begin () + numKept);
+                }
+
+                newSamples += numRead;
+            }
+
+            // a quarter of the window is new, so successive spectra overlap by 75%
+            if (newSamples >= spectrumSize / 4)
+            {
+                newSamples = 0;
+                analyseSpectra (sampleRate);
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            ++working.version;
+
+            const SpinLock::ScopedLockType sl (curvesLock);
+            curves = working;
+        }
+
+        wait (1000 / refreshRate);
+    }
+}
+
+void ResponseAnalyser::analyseResponse (const FirFilter::Coefficients& coefficients, double sampleRate)
+{
+    const auto numTaps = (int)coefficients.getFilterSize ();
+    const auto* taps = coefficients.getRawCoefficients ();
+
+    // at least 16k points, so that the low end has a few Hz resolution, and no time aliasing
+    const auto order = jmax (14, (int)std::ceil (std::log2 (jmax (2, 2 * numTaps))));
+
+    if (responseFFT == nullptr || responseFFT->getSize () != (1 << order))
+    {
+        responseFFT = std::make_unique<dsp::FFT> (order);
+        impulse.resize ((size_t)(2 << order));
+        rampedImpulse.resize ((size_t)(2 << order));
+    }
+
+    const auto size = responseFFT->getSize ();
+    const auto numBins = size / 2 + 1;
+
+    std::fill (impulse.begin (), impulse.end (), 0.f);
+    std::fill (rampedImpulse.begin (), rampedImpulse.end (), 0.f);
+
+    for (int n = 0; n < numTaps; ++n)
+    {
+        impulse[(size_t)n] = taps[n];
+        rampedImpulse[(size_t)n] = (float)n * taps[n];
+    }
+
+    // the group delay is Re (FFT (n h) / FFT (h)), which needs no phase unwrapping
+    responseFFT->performRealOnlyForwardTransform (impulse.data (), true);
+    responseFFT->performRealOnlyForwardTransform (rampedImpulse.data (), true);
+
+    auto peak = 0.f;
+
+    for (int k = 0; k < numBins; ++k)
+        peak = jmax (peak, std::hypot (impulse[(size_t)(2 * k)], impulse[(size_t)(2 * k + 1)]));
+
+    working.responseFrequencies.resize ((size_t)numBins);
+    working.magnitudeDecibels.resize ((size_t)numBins);
+    working.phase.resize ((size_t)numBins);
+    working.groupDelayMilliseconds.resize ((size_t)numBins);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const std::complex<float> h { impulse[(size_t)(2 * k)], impulse[(size_t)(2 * k + 1)] };
+        const std::complex<float> ramped { rampedImpulse[(size_t)(2 * k)], rampedImpulse[(size_t)(2 * k + 1)] };
+        const auto magnitude = std::abs (h);
+
+        working.responseFrequencies[(size_t)k] = (float)(k * sampleRate / size);
+        working.magnitudeDecibels[(size_t)k] = Decibels::gainToDecibels (magnitude, -200.f);
+        working.phase[(size_t)k] = std::arg (h);
+
+        // 100 dB below the peak the ratio is mostly rounding noise
+        working.groupDelayMilliseconds[(size_t)k] = magnitude > peak * 1.0e-5f
+            ? (float)((ramped * std::conj (h)).real () / std::norm (h) * 1000.0 / sampleRate)
+            : std::numeric_limits<float>::quiet_NaN ();
+    }
+}
+
+void ResponseAnalyser::analyseSpectra (double sampleRate)
+{
+    const auto numBins = spectrumSize / 2 + 1;
+
+    // a full scale sine peaks at spectrumSize / 4 through the Hann window
+    const auto scale = 4.f / (float)spectrumSize;
+
+    for (auto [history, power] : { std::pair (&inputHistory, &inputPower), std::pair (&outputHistory, &outputPower) })
+    {
+        std::copy (history->begin (), history->end (), fftBuffer.begin ());
+        window.multiplyWithWindowingTable (fftBuffer.data (), (size_t)spectrumSize);
+        spectrumFFT.performFrequencyOnlyForwardTransform (fftBuffer.data (), true);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            const auto magnitude = fftBuffer[(size_t)k] * scale;
+            auto& smoothed = (*power)[(size_t)k];
+            smoothed = spectrumSmoothing * smoothed + (1.f - spectrumSmoothing) * magnitude * magnitude;
+        }
+    }
+
+    working.spectrumFrequencies.resize ((size_t)numBins);
+    working.inputDecibels.resize ((size_t)numBins);
+    working.outputDecibels.resize ((size_t)numBins);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        working.spectrumFrequencies[(size_t)k] = (float)(k * sampleRate / spectrumSize);
+        working.inputDecibels[(size_t)k] = toDecibels (inputPower[(size_t)k]);
+        working.outputDecibels[(size_t)k] = toDecibels (outputPower[(size_t)k]);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Filter.h"
+
+/** Computes what a FirFilter display shows, on a thread of its own.
+
+    Whenever the filter's active coefficients change, their magnitude, phase and group
+    delay are evaluated on an FFT kept from one set to the next as long as its size is
+    still right. In between, the first channel's input and output are read from the
+    filter's SignalTap and turned into smoothed spectra. The thread runs at the rate of a
+    display, so the tap only has to hold a few blocks, and it is only active while the
+    analyser exists.
+
+    The results are copied out with getCurves(), which never waits for a computation.
+*/
+class ResponseAnalyser : private Thread
+{
+public:
+    static constexpr int spectrumOrder = 12;
+    static constexpr int spectrumSize = 1 << spectrumOrder;
+
+    ResponseAnalyser (FirFilter& filter);
+    ~ResponseAnalyser () override;
+
+    /** One value per bin; frequencies are in Hz. */
+    struct Curves
+    {
+        uint32 version = 0;
+
+        // response of the active coefficients, empty when there are none
+        std::vector<float> responseFrequencies;
+        std::vector<float> magnitudeDecibels;
+        std::vector<float> phase;                       // in radians, wrapped to [-pi, pi]
+        std::vector<float> groupDelayMilliseconds;     // NaN where the magnitude is too low to tell
+
+        // live spectra of the first channel, at the host's rate
+        std::vector<float> spectrumFrequencies;
+        std::vector<float> inputDecibels;
+        std::vector<float> outputDecibels;
+    };
+
+    /** Copies the latest results if their version differs from the one in curves and
+        returns true, or returns false if there is nothing new or a computation is busy.
+    */
+    bool getCurves (Curves& curves) const;
+
+private:
+    void run () override;
+    void analyseResponse (const FirFilter::Coefficients& coefficients, double sampleRate);
+    void analyseSpectra (double sampleRate);
+
+    FirFilter& filter;
+
+    // everything below is only touched by the analyser's thread, apart from curves and the lock
+    uint32 coefficientsVersion = 0;
+    std::unique_ptr<dsp::FFT> responseFFT;
+    std::vector<float> impulse, rampedImpulse;
+
+    dsp::FFT spectrumFFT { spectrumOrder };
+    dsp::WindowingFunction<float> window { (size_t)spectrumSize, dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> inputHistory, outputHistory, readBuffer, fftBuffer;
+    std::vector<float> inputPower, outputPower;
+    int newSamples = 0;
+
+    Curves working;
+    mutable SpinLock curvesLock;
+    Curves curves;
+
+    JUCE_DECLARE_NON_COPYABLE (ResponseAnalyser)
+};
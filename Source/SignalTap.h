@@ -0,0 +1,92 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Carries one channel of a processor's input and output from the audio thread to a reader.
+
+    The audio thread reserves room in a single producer, single consumer FIFO before it
+    processes a block, copies the input there, and publishes the block once the output has
+    been copied next to it; pairs of samples therefore always belong to the same moment.
+    Both sides are wait-free: when the reader falls behind, whole blocks are dropped rather
+    than waited for, and nothing is copied at all while the tap is inactive.
+*/
+class SignalTap
+{
+public:
+    static constexpr int capacity = 1 << 15;
+
+    SignalTap ()
+    {
+        input.resize ((size_t)capacity);
+        output.resize ((size_t)capacity);
+    }
+
+    /** Reader: starts or stops the copying. The FIFO is emptied when starting. */
+    void setActive (bool shouldBeActive)
+    {
+        if (shouldBeActive)
+            fifo.finishedRead (fifo.getNumReady ());
+
+        active = shouldBeActive;
+    }
+
+    //==============================================================================
+    /** Audio thread: copies a block's input. Call before it is processed in place. */
+    void writeInput (const float* samples, int numSamples) noexcept
+    {
+        pending = {};
+
+        if (! active.load (std::memory_order_relaxed) || numSamples > fifo.getFreeSpace ())
+            return;
+
+        fifo.prepareToWrite (numSamples, pending.start1, pending.size1, pending.start2, pending.size2);
+        copy (input, samples);
+    }
+
+    /** Audio thread: copies the same block's output and makes the pair visible to the reader. */
+    void writeOutput (const float* samples) noexcept
+    {
+        if (pending.size1 + pending.size2 == 0)
+            return;
+
+        copy (output, samples);
+        fifo.finishedWrite (pending.size1 + pending.size2);
+        pending = {};
+    }
+
+    //==============================================================================
+    /** Reader: takes up to maxNumSamples pairs and returns how many were taken. */
+    int read (float* inputDestination, float* outputDestination, int maxNumSamples)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxNumSamples, start1, size1, start2, size2);
+
+        for (auto [source, destination] : { std::pair (&input, inputDestination), std::pair (&output, outputDestination) })
+        {
+            std::copy_n (source->data () + start1, size1, destination);
+            std::copy_n (source->data () + start2, size2, destination + size1);
+        }
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    struct Range
+    {
+        int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+    };
+
+    void copy (std::vector<float>& destination, const float* samples) noexcept
+    {
+        std::memcpy (destination.data () + pending.start1, samples, sizeof (float) * (size_t)pending.size1);
+        std::memcpy (destination.data () + pending.start2, samples + pending.size1, sizeof (float) * (size_t)pending.size2);
+    }
+
+    AbstractFifo fifo { capacity };
+    std::vector<float> input, output;
+    Range pending;
+    std::atomic<bool> active { false };
+
+    JUCE_DECLARE_NON_COPYABLE (SignalTap)
+};